@@ -1,8 +1,21 @@
 ﻿#include "SDL.h"
 #include <vector>
+#include <algorithm>
 #include <array>
-#include <list>
+#include <string>
 #include <math.h>
+#include <stdlib.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define GM_STICK_SSE
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 typedef double GMReal;
 typedef const char* GMString;
@@ -14,9 +27,13 @@ typedef unsigned int uint;
 // 0 - 99: 手柄的原始按钮值
 // 100 - 125: 已定义的手柄按钮常量
 // 126 - 131: 已定义的手柄摇杆常量
+// 132 - 134: ANY
+// 135 - 146: 左摇杆、右摇杆与十字键量化后的方向（上、下、左、右）
 constexpr int DefinedButtonOffset = 100;
 constexpr int DefinedAxisOffset = DefinedButtonOffset + SDL_GAMEPAD_BUTTON_COUNT;
-constexpr int ButtonCount = DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT + 3;
+constexpr int DirectionOffset = DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT + 3;
+constexpr int DirectionSourceCount = 3;
+constexpr int ButtonCount = DirectionOffset + DirectionSourceCount * 4;
 
 // 0 - 59: 手柄的原始按钮值
 // 60 - 79: 手柄的原始摇杆值
@@ -31,796 +48,5345 @@ enum ExtraSDL
 	SDL_GAMEPAD_ANY
 };
 
-struct GMGamepad
+// 输入名称表：已定义的按钮与摇杆使用 SDL 映射字符串中的名称，原始输入使用 button0、axis0、hat0up 等名称。
+struct InputNameEntry
 {
-	// 当接入 SDL3 支持的手柄时，gamepad 和 joystick 都不为 nullptr；
-	// 当接入 SDL3 不支持的手柄时，gamepad 为 nullptr，joystick 不为 nullptr。
-	// 永远不会出现 gamepad 不为 nullptr，joystick 为 nullptr 的情况。
-	SDL_Gamepad* gamepad;
-	SDL_Joystick* joystick;
+	char text[16];
+	int code;
+};
 
-	SDL_GamepadBinding** bindings = nullptr;
-	int binding_count = 0;
+constexpr int InputNameCount = ButtonCount;
 
-	double deadzone = 0.05;
-	std::array<char, ButtonCount> button_events;
+constexpr const char* DefinedButtonNames[SDL_GAMEPAD_BUTTON_COUNT] = {
+	"a", "b", "x", "y", "back", "guide", "start", "leftstick", "rightstick",
+	"leftshoulder", "rightshoulder", "dpup", "dpdown", "dpleft", "dpright", "misc1",
+	"paddle1", "paddle2", "paddle3", "paddle4", "touchpad", "misc2", "misc3", "misc4", "misc5", "misc6"
 };
 
-std::vector<GMGamepad> sticks;
-SDL_Event my_event;
-
-bool gp_updated = false;
+constexpr const char* DefinedAxisNames[SDL_GAMEPAD_AXIS_COUNT] = {
+	"leftx", "lefty", "rightx", "righty", "lefttrigger", "righttrigger"
+};
 
-inline double lerp(double fromA, double fromB, double toA, double toB, double value)
-{
-	return ((value - fromA) / (fromB - fromA)) * (toB - toA) + toA;
-}
+constexpr const char* HatDirectionNames[4] = { "up", "down", "left", "right" };
 
-#define sign(x) ((x > 0) - (x < 0))
+constexpr const char* DirectionSourceNames[DirectionSourceCount] = { "leftstick", "rightstick", "dpad" };
 
-template<typename T>
-std::vector<T> GamepadGetHat(int hatMask, T up, T down, T left, T right)
+// 名称由 prefix、number（小于 0 时省略）和 suffix 拼接而成
+constexpr void InputNameSet(InputNameEntry& entry, const char* prefix, int number, const char* suffix, int code)
 {
-	switch (hatMask)
+	int length = 0;
+	for (const char* c = prefix; *c != '\0'; c++)
+		entry.text[length++] = *c;
+
+	if (number >= 0)
 	{
-	case SDL_HAT_UP:  return { up };
-	case SDL_HAT_DOWN: return { down };
-	case SDL_HAT_LEFT: return { left };
-	case SDL_HAT_RIGHT: return { right };
-	case SDL_HAT_LEFTUP: return { up, left };
-	case SDL_HAT_LEFTDOWN: return { down, left };
-	case SDL_HAT_RIGHTUP: return { up, right };
-	case SDL_HAT_RIGHTDOWN: return { down, right };
-	default: return {};
+		char digits[4] = {};
+		int count = 0;
+		do
+		{
+			digits[count++] = (char)('0' + number % 10);
+			number /= 10;
+		} while (number > 0);
+
+		while (count > 0)
+			entry.text[length++] = digits[--count];
 	}
+
+	for (const char* c = suffix; *c != '\0'; c++)
+		entry.text[length++] = *c;
+
+	entry.text[length] = '\0';
+	entry.code = code;
 }
 
-expReal gamepad_init(GMString gamepadDB)
+constexpr std::array<InputNameEntry, InputNameCount> BuildInputNames()
 {
-	if (*gamepadDB != '\0')
-		SDL_AddGamepadMappingsFromFile(gamepadDB);
+	std::array<InputNameEntry, InputNameCount> names{};
+	int n = 0;
 
-	bool result = SDL_Init(SDL_INIT_GAMEPAD);
-	SDL_SetGamepadEventsEnabled(true);
-	return result;
+	for (int i = 0; i < JoystickAxisOffset; i++)
+		InputNameSet(names[n++], "button", i, "", i);
+
+	for (int i = 0; i < JoystickHatOffset - JoystickAxisOffset; i++)
+		InputNameSet(names[n++], "axis", i, "", JoystickAxisOffset + i);
+
+	for (int i = 0; i < (DefinedButtonOffset - JoystickHatOffset) / 4; i++)
+	{
+		for (int d = 0; d < 4; d++)
+			InputNameSet(names[n++], "hat", i, HatDirectionNames[d], JoystickHatOffset + i * 4 + d);
+	}
+
+	for (int i = 0; i < SDL_GAMEPAD_BUTTON_COUNT; i++)
+		InputNameSet(names[n++], DefinedButtonNames[i], -1, "", DefinedButtonOffset + i);
+
+	for (int i = 0; i < SDL_GAMEPAD_AXIS_COUNT; i++)
+		InputNameSet(names[n++], DefinedAxisNames[i], -1, "", DefinedAxisOffset + i);
+
+	InputNameSet(names[n++], "anybutton", -1, "", SDL_GAMEPAD_BUTTON_ANY);
+	InputNameSet(names[n++], "anyaxis", -1, "", SDL_GAMEPAD_AXIS_ANY);
+	InputNameSet(names[n++], "any", -1, "", SDL_GAMEPAD_ANY);
+
+	for (int i = 0; i < DirectionSourceCount; i++)
+	{
+		for (int d = 0; d < 4; d++)
+			InputNameSet(names[n++], DirectionSourceNames[i], -1, HatDirectionNames[d], DirectionOffset + i * 4 + d);
+	}
+
+	return names;
 }
 
-expReal gamepad_is_supported(GMReal id)
+constexpr std::array<InputNameEntry, InputNameCount> InputNames = BuildInputNames();
+
+// 不区分大小写的 FNV-1a 哈希，seed 用于完美哈希的二次哈希
+constexpr Uint32 HashInputName(const char* name, Uint32 seed)
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return 0;
+	Uint32 hash = 2166136261u ^ (seed * 0x9E3779B9u);
+	for (; *name != '\0'; name++)
+	{
+		char c = *name;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
 
-	return sticks[index].gamepad != nullptr;
+		hash = (hash ^ (Uint8)c) * 16777619u;
+	}
+
+	return hash;
 }
 
-expReal gamepad_get_device_count() { return sticks.size(); }
+// 编译期生成的完美哈希（hash and displace）：名称先以 seed 0 的哈希选择桶，
+// 再以该桶的 seed 重新哈希得到槽位。生成时为每个桶寻找一个使桶内名称都落在空槽位上的 seed。
+constexpr int InputHashBuckets = 64;
+constexpr int InputHashSlots = 256;
 
-expString gamepad_get_description(GMReal id)
+struct InputNameHashTable
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return "no gamepad";
+	std::array<Uint16, InputHashBuckets> seeds{};
+	std::array<Sint16, InputHashSlots> slots{};  // InputNames 的下标，-1 表示空槽位
+	bool valid = false;
+};
+
+constexpr InputNameHashTable BuildInputNameHashTable()
+{
+	InputNameHashTable table{};
+	for (auto& slot : table.slots)
+		slot = -1;
+
+	std::array<int, InputNameCount> bucket_of{};
+	std::array<int, InputHashBuckets> bucket_sizes{};
+	for (int i = 0; i < InputNameCount; i++)
+	{
+		bucket_of[i] = HashInputName(InputNames[i].text, 0) % InputHashBuckets;
+		bucket_sizes[bucket_of[i]]++;
+	}
+
+	int max_size = 0;
+	for (int size : bucket_sizes)
+		max_size = size > max_size ? size : max_size;
+
+	// 先放置名称较多的桶
+	for (int size = max_size; size > 0; size--)
+	{
+		for (int bucket = 0; bucket < InputHashBuckets; bucket++)
+		{
+			if (bucket_sizes[bucket] != size)
+				continue;
+
+			std::array<int, InputNameCount> members{};
+			int count = 0;
+			for (int i = 0; i < InputNameCount; i++)
+			{
+				if (bucket_of[i] == bucket)
+					members[count++] = i;
+			}
+
+			bool placed = false;
+			for (Uint32 seed = 1; seed <= 0xFFFF && !placed; seed++)
+			{
+				std::array<int, InputNameCount> chosen{};
+				bool fits = true;
+				for (int m = 0; m < count && fits; m++)
+				{
+					chosen[m] = HashInputName(InputNames[members[m]].text, seed) % InputHashSlots;
+					if (table.slots[chosen[m]] != -1)
+						fits = false;
+
+					for (int k = 0; k < m && fits; k++)
+					{
+						if (chosen[k] == chosen[m])
+							fits = false;
+					}
+				}
+
+				if (!fits)
+					continue;
+
+				for (int m = 0; m < count; m++)
+					table.slots[chosen[m]] = (Sint16)members[m];
+
+				table.seeds[bucket] = (Uint16)seed;
+				placed = true;
+			}
+
+			if (!placed)
+				return table;
+		}
+	}
 
-	return SDL_GetJoystickName(sticks[index].joystick);
+	table.valid = true;
+	return table;
 }
 
-expReal gamepad_get_type(GMReal id)
+constexpr InputNameHashTable InputNameHash = BuildInputNameHashTable();
+static_assert(InputNameHash.valid, "failed to build the perfect hash of input names");
+
+// 将输入名称解析为输入值，名称无效时返回 -1
+inline int InputCodeFromName(const char* name)
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
+	if (name == nullptr)
 		return -1;
 
-	if (sticks[index].gamepad == nullptr)
-		return SDL_GAMEPAD_TYPE_UNKNOWN;
+	Uint32 seed = InputNameHash.seeds[HashInputName(name, 0) % InputHashBuckets];
+	int entry = InputNameHash.slots[HashInputName(name, seed) % InputHashSlots];
+	if (entry < 0 || SDL_strcasecmp(InputNames[entry].text, name) != 0)
+		return -1;
 
-	return SDL_GetGamepadType(sticks[index].gamepad);
+	return InputNames[entry].code;
 }
 
-expString gamepad_get_guid(GMReal id)
+// 对数分桶的延迟直方图（微秒）：每个 2 的幂区间再均分为 4 个子桶，相对误差不超过 12.5%
+struct GMLatencyHistogram
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return "device index out of range";
+	static constexpr int SubBucketBits = 2;
+	static constexpr int SubBuckets = 1 << SubBucketBits;
+	static constexpr int Octaves = 40;
+	static constexpr int BucketCount = 1 + Octaves * SubBuckets;
 
-	SDL_GUID guid = SDL_GetJoystickGUID(sticks[index].joystick);
-	bool error = true;
-	for (uint i = 0; i < 16; ++i)
+	std::array<Uint32, BucketCount> buckets{};
+	Uint64 count = 0;
+
+	static int BucketIndex(Uint64 us)
 	{
-		if (guid.data[i] != 0)
+		if (us == 0)
+			return 0;
+
+		int e = 63;
+		while ((us >> e) == 0)
+			e--;
+
+		int sub = e >= SubBucketBits ? (int)(us >> (e - SubBucketBits)) : (int)(us << (SubBucketBits - e));
+		int index = 1 + e * SubBuckets + (sub & (SubBuckets - 1));
+		return std::min(index, BucketCount - 1);
+	}
+
+	// 返回桶的中点值
+	static double BucketValue(int index)
+	{
+		if (index == 0)
+			return 0;
+
+		int e = (index - 1) / SubBuckets;
+		int sub = (index - 1) % SubBuckets;
+		double width = ldexp(1.0, e) / SubBuckets;
+		return ldexp(1.0, e) + width * (sub + 0.5);
+	}
+
+	void Add(Uint64 ns)
+	{
+		buckets[BucketIndex(ns / 1000)]++;
+		count++;
+	}
+
+	double Percentile(double percent) const
+	{
+		if (count == 0)
+			return 0;
+
+		Uint64 target = (Uint64)ceil(SDL_clamp(percent, 0.0, 100.0) / 100 * count);
+		target = std::max<Uint64>(target, 1);
+
+		Uint64 cumulative = 0;
+		for (int i = 0; i < BucketCount; i++)
 		{
-			error = false;
-			break;
+			cumulative += buckets[i];
+			if (cumulative >= target)
+				return BucketValue(i);
 		}
+
+		return BucketValue(BucketCount - 1);
 	}
-	if (error)
-		return "none";
+};
 
-	char* guid_str = new char[33];
-	SDL_GUIDToString(guid, guid_str, 33);
+// 以 SDL 事件时间戳增量统计的上报间隔。同一时间戳的事件视为同一份上报；
+// 只有上一份上报时手柄处于输入状态才计入间隔，避免把空闲时间当作掉线。
+struct GMReportStats
+{
+	Uint64 last_timestamp = 0;
+	Uint64 gap_threshold = 100 * SDL_NS_PER_MS;
 
-	return guid_str;
-}
+	Uint64 intervals = 0;
+	double mean = 0;  // 纳秒
+	double m2 = 0;
+	Uint64 max_interval = 0;
+	Uint64 gaps = 0;
 
-expReal gamepad_get_id(GMReal id)
-{
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return -1;
+	void Add(Uint64 timestamp, bool active)
+	{
+		if (timestamp == last_timestamp)
+			return;
 
-	return SDL_GetJoystickID(sticks[index].joystick);
-}
+		if (active && last_timestamp != 0 && timestamp > last_timestamp)
+		{
+			Uint64 interval = timestamp - last_timestamp;
+			if (interval > gap_threshold)
+				gaps++;  // 掉线的间隔不计入上报率
+			else
+			{
+				intervals++;
+				double delta = interval - mean;
+				mean += delta / intervals;
+				m2 += delta * (interval - mean);
+			}
 
-expReal gamepad_get_axis_deadzone(GMReal id)
+			max_interval = std::max(max_interval, interval);
+		}
+
+		last_timestamp = timestamp;
+	}
+
+	double Rate() const { return mean > 0 ? 1e9 / mean : 0; }
+	double Jitter() const { return intervals > 1 ? sqrt(m2 / (intervals - 1)) / 1000 : 0; }
+};
+
+// 设备的字符串信息，在接入或映射改变时生成一次。
+// 导出函数返回的指针在下一次 gamepad_update 或映射改变之前有效。
+struct GMDeviceStrings
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return 0;
+	std::string name;
+	std::string guid;
+	std::string mapping;
+	std::string serial;
+	std::string path;
+	std::string type_name;
+	std::string info;  // gamepad_get_info 返回的汇总信息
+};
 
-	return sticks[(uint)id].deadzone;
-}
+// 设备的固定信息，在接入或映射改变时获取一次，之后的查询不再进入 SDL（也就不再占用 SDL 的手柄锁）
+struct GMDeviceInfo
+{
+	SDL_JoystickID instance_id = 0;
+	SDL_GUID guid{};
+	int axis_count = 0;
+	int button_count = 0;
+	int hat_count = 0;
+	int type = SDL_GAMEPAD_TYPE_UNKNOWN;
+	Uint16 vendor = 0;
+	Uint16 product = 0;
+	Uint16 version = 0;
+	Uint16 firmware = 0;
+	int connection_state = SDL_JOYSTICK_CONNECTION_INVALID;
+	Uint32 button_mask = 0;  // 第 n 位表示手柄拥有 SDL_GamepadButton n
+	Uint32 axis_mask = 0;    // 第 n 位表示手柄拥有 SDL_GamepadAxis n
+	Uint32 sensor_mask = 0;  // 第 n 位表示手柄拥有 SDL_SensorType n
+	int touchpad_count = 0;
+};
 
-expReal gamepad_set_axis_deadzone(GMReal id, GMReal deadzone)
+// 按钮状态的位图，第 n 个字的第 k 位对应输入值 32 * n + k
+constexpr int InputMaskWords = (ButtonCount + 31) / 32;
+
+struct GMInputMasks
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return 0;
+	std::array<Uint32, InputMaskWords> held{};
+	std::array<Uint32, InputMaskWords> pressed{};
+	std::array<Uint32, InputMaskWords> released{};
+};
 
-	sticks[(uint)id].deadzone = SDL_clamp(deadzone, 0.0, 1.0);
-	return 1;
-}
+// 最近一次按下的输入
+struct GMLastInput
+{
+	int code = -1;
+	Uint64 timestamp = 0;  // SDL 事件时间戳（纳秒）
+};
 
-expReal gamepad_axis_value(GMReal id, GMReal axis)
+// 由 bindings 生成的查询表，下标为已定义的输入值（100 - 131）减去 DefinedButtonOffset
+struct GMBindingTable
 {
-	uint index = (uint)id;
-	int iaxis = (int)axis;
-	if (index >= sticks.size() || iaxis < JoystickAxisOffset)
-		return 0;
+	static constexpr int Size = DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT - DefinedButtonOffset;
 
-	double value;
-	if (iaxis < DefinedAxisOffset)
+	std::array<Sint16, Size> original;  // 对应的原始输入值，-1 表示没有
+	std::array<Sint16, Size> any;       // 对应的 ANY 输入值，SDL_GAMEPAD_BUTTON_INVALID 表示没有
+
+	GMBindingTable()
 	{
-		value = (double)SDL_GetJoystickAxis(sticks[index].joystick, iaxis - JoystickAxisOffset) / 32767;
-		value = SDL_clamp(value, -1.0, 1.0);
+		original.fill(-1);
+		any.fill(SDL_GAMEPAD_BUTTON_INVALID);
 	}
-	else
-	{
-		SDL_GamepadAxis axis_enum = (SDL_GamepadAxis)(iaxis - DefinedAxisOffset);
+};
 
-		value = (double)SDL_GetGamepadAxis(sticks[index].gamepad, axis_enum) / 32767;
-		value = SDL_clamp(value, -1.0, 1.0);
-	}
+// 软件映射中的一个绑定：原始输入到已定义输入的转换
+struct GMSoftBinding
+{
+	Uint8 output;  // 已定义的输入值减去 DefinedButtonOffset，小于 SDL_GAMEPAD_BUTTON_COUNT 时为按钮
+	float in_lo;   // 原始摇杆的归一化取值范围，in_lo 映射至 out_lo，in_hi 映射至 out_hi
+	float in_hi;
+	float out_lo;  // 输出摇杆的取值范围
+	float out_hi;
+};
 
-	if (fabs(value) < sticks[index].deadzone)
-		return 0;
+// 软件映射：SDL 无法识别的手柄根据 SDL 格式的映射字符串，在处理事件时将原始输入转换为已定义的输入值（100 - 131）
+struct GMSoftMapping
+{
+	bool enabled = false;
+	std::string source;  // 原始的映射字符串，用于保存至设备配置
+
+	// 原始输入值 i 的绑定为 bindings[first[i]] 至 bindings[first[i + 1] - 1]
+	std::array<Uint16, DefinedButtonOffset + 1> first{};
+	std::vector<GMSoftBinding> bindings;
+	GMBindingTable table;
+
+	// 每个绑定当前的输出：按钮为 0 或 1，摇杆为对输出摇杆的贡献值
+	std::vector<float> contributions;
+	std::array<Uint8, SDL_GAMEPAD_BUTTON_COUNT> button_sources{};  // 正在按下该按钮的绑定数量
+	std::array<float, SDL_GAMEPAD_AXIS_COUNT> axes{};
+};
 
-	value = lerp(sticks[index].deadzone, 1, 0, 1, fabs(value)) * sign(value);
-	return value;
-}
+// 摇杆槽位：0 - 19 为原始摇杆（60 - 79），20 - 25 为已定义的摇杆（126 - 131）
+constexpr int AxisSlotCount = (JoystickHatOffset - JoystickAxisOffset) + SDL_GAMEPAD_AXIS_COUNT;
+constexpr int AxisLutSegments = 512;
 
-expReal gamepad_button_check_direct(GMReal id, GMReal button)
+int AxisSlot(int input)
 {
-	uint index = (uint)id;
-	if (index >= sticks.size() || button < 0)
-		return 0;
+	if (input >= JoystickAxisOffset && input < JoystickHatOffset)
+		return input - JoystickAxisOffset;
+	if (input >= DefinedAxisOffset && input < DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+		return JoystickHatOffset - JoystickAxisOffset + input - DefinedAxisOffset;
 
-	int input = (int)button;
+	return -1;
+}
 
-	if (input < DefinedButtonOffset)
+// 摇杆处理流水线的配置，各阶段按顺序作用于摇杆偏离原位的距离：
+// 内/外死区 -> 反死区 -> 响应曲线 -> 灵敏度 -> 反转 -> 限制范围
+struct GMAxisConfig
+{
+	float inner_deadzone = 0.05f;  // 不超过该值时输出 0
+	float outer_deadzone = 1.0f;   // 超过该值时视为推到底
+	float anti_deadzone = 0.0f;    // 离开死区后的最小输出，用于抵消游戏自身的死区
+	float curve = 1.0f;            // 响应曲线的指数，1 为线性
+	float sensitivity = 1.0f;
+	bool invert = false;
+	float clamp = 1.0f;            // 输出的最大绝对值
+
+	// 作为按钮使用时的阈值（输出值的绝对值）：超过 press_threshold 时按下，低于 release_threshold 时放开。
+	// 两者均为 0 时，离开死区即按下，回到死区即放开。
+	float press_threshold = 0.0f;
+	float release_threshold = 0.0f;
+
+	// One-Euro 平滑（gamepad_axis_value_filtered）：最小截止频率（Hz，0 为关闭）、速度系数与速度的截止频率。
+	// 静止时按最小截止频率平滑抖动，移动越快截止频率越高，延迟越小。
+	float filter_min_cutoff = 0.0f;
+	float filter_beta = 0.0f;
+	float filter_d_cutoff = 1.0f;
+};
+
+// 由 GMAxisConfig 编译出的处理函数：除内死区外的所有阶段合并为一张查找表，
+// 每个摇杆事件只需一次比较与一次线性插值，与原来的死区计算开销相同
+struct GMAxisKernel
+{
+	float threshold = 0;
+	float scale = 0;  // 将死区之间的距离映射至查找表的下标
+	float sign = 1;
+	float press_raw = 0;    // 由按下、放开阈值换算出的死区之前的距离
+	float release_raw = 0;
+	std::array<float, AxisLutSegments + 2> lut{};  // 最后一项重复，插值时不需要判断边界
+
+	void Compile(const GMAxisConfig& config)
 	{
-		if (input < JoystickAxisOffset)
-			return SDL_GetJoystickButton(sticks[index].joystick, input);
-		else if (input < JoystickHatOffset)
+		float inner = SDL_clamp(config.inner_deadzone, 0.0f, 1.0f);
+		float outer = SDL_clamp(config.outer_deadzone, inner + 0.0001f, 1.0f);
+		float anti = SDL_clamp(config.anti_deadzone, 0.0f, 1.0f);
+		float curve = SDL_max(config.curve, 0.01f);
+		float limit = SDL_clamp(config.clamp, 0.0f, 1.0f);
+
+		threshold = inner;
+		scale = AxisLutSegments / (outer - inner);
+		sign = config.invert ? -1.0f : 1.0f;
+		for (int i = 0; i <= AxisLutSegments; i++)
 		{
-			GMReal value = gamepad_axis_value(id, input);
-			return fabs(sign(value));
+			float t = (float)i / AxisLutSegments;
+			float shaped = curve == 1.0f ? t : powf(t, curve);
+			float value = (anti + (1.0f - anti) * shaped) * config.sensitivity;
+			lut[i] = SDL_clamp(value, 0.0f, limit);
 		}
-		else
+		lut[AxisLutSegments + 1] = lut[AxisLutSegments];
+
+		float press = SDL_clamp(config.press_threshold, 0.0f, 1.0f);
+		float release = SDL_clamp(config.release_threshold, 0.0f, press);
+		press_raw = RawDistance(press);
+		release_raw = RawDistance(release);
+	}
+
+	// 在查找表中找到输出值首次达到 output 的位置，换算为死区之前的距离。无法达到时返回 2（永远不会按下）。
+	float RawDistance(float output) const
+	{
+		if (output <= 0)
+			return threshold;
+
+		for (int i = 1; i <= AxisLutSegments; i++)
 		{
-			int mask = SDL_GetJoystickHat(sticks[index].joystick, (input - JoystickHatOffset) / 4);
-			auto list = GamepadGetHat(mask, 0, 1, 2, 3);
-			for (auto inp : list)
-			{
-				if (inp == (input - JoystickHatOffset) % 4)
-					return 1;  // 按下
-			}
+			if (lut[i] < output)
+				continue;
+
+			float x = (i - 1) + (output - lut[i - 1]) / SDL_max(lut[i] - lut[i - 1], 1e-6f);
+			return threshold + SDL_max(x, 0.0f) / scale;
 		}
-		return SDL_GetJoystickButton(sticks[index].joystick, input);
+
+		return 2.0f;
 	}
-	else if (input < DefinedAxisOffset)
+
+	// 带滞回的按下状态，value 为死区之前的值
+	bool Held(bool held, float value) const
 	{
-		return SDL_GetGamepadButton(sticks[index].gamepad, (SDL_GamepadButton)
-			(input - DefinedButtonOffset));
+		return fabsf(value) > (held ? release_raw : press_raw);
 	}
-	else if (input < DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+
+	// value 为归一化的摇杆值 [-1, 1]
+	float Process(float value) const
 	{
-		GMReal value = gamepad_axis_value(id, input);
-		return fabs(sign(value));
+		float magnitude = fabsf(value);
+		if (magnitude <= threshold)
+			return 0;
+
+		float result = Lookup(SDL_min((magnitude - threshold) * scale, (float)AxisLutSegments));
+		return value < 0 ? -result * sign : result * sign;
 	}
 
-	return 0;
-}
+	// 对已经过死区处理的距离 t [0, 1] 执行之后的阶段（不含反转）
+	float Shape(float t) const
+	{
+		return Lookup(SDL_clamp(t, 0.0f, 1.0f) * AxisLutSegments);
+	}
 
-expReal gamepad_button_check(GMReal id, GMReal button)
+	float Lookup(float x) const
+	{
+		int i = (int)x;
+		return lut[i] + (lut[i + 1] - lut[i]) * (x - i);
+	}
+};
+
+// 二维摇杆：左、右摇杆与相邻的两个原始摇杆（60 与 61、62 与 63 ……）作为一个向量处理
+// 0: 左摇杆  1: 右摇杆  2 - 11: 原始摇杆对
+constexpr int StickCount = 2 + (JoystickHatOffset - JoystickAxisOffset) / 2;
+
+enum StickMode
 {
-	uint index = (uint)id;
-	int input = (int)button;
-	if (index >= sticks.size() || input >= ButtonCount)
+	STICK_MODE_AXIAL,          // 每个轴单独处理，与 gamepad_axis_value 相同
+	STICK_MODE_RADIAL,         // 圆形死区，死区外保持原始距离
+	STICK_MODE_SCALED_RADIAL,  // 圆形死区，死区外的距离重新映射至 [0, 1]
+	STICK_MODE_BOWTIE,         // 圆形死区外，每个轴的死区随另一个轴的偏移增大，便于沿轴线精确移动
+	STICK_MODE_COUNT
+};
+
+// 由摇杆 X 轴的输入值（126、128、60、62 ……）得到二维摇杆的编号
+int StickIndex(int input)
+{
+	if (input == DefinedAxisOffset + SDL_GAMEPAD_AXIS_LEFTX)
 		return 0;
+	if (input == DefinedAxisOffset + SDL_GAMEPAD_AXIS_RIGHTX)
+		return 1;
+	if (input >= JoystickAxisOffset && input < JoystickHatOffset && (input - JoystickAxisOffset) % 2 == 0)
+		return 2 + (input - JoystickAxisOffset) / 2;
 
-	return (sticks[index].button_events[input] & 0b100) != 0;
+	return -1;
 }
 
-expReal gamepad_button_check_pressed(GMReal id, GMReal button)
+// 二维摇杆 X 轴的摇杆槽位，Y 轴为下一个槽位
+int StickSlot(int stick)
 {
-	uint index = (uint)id;
-	int input = (int)button;
-	if (index >= sticks.size() || input >= ButtonCount)
-		return 0;
+	if (stick < 2)
+		return JoystickHatOffset - JoystickAxisOffset + stick * 2;
 
-	return (sticks[index].button_events[input] & 0b001) != 0;
+	return (stick - 2) * 2;
 }
 
-expReal gamepad_button_check_released(GMReal id, GMReal button)
+int StickFromSlot(int slot)
 {
-	uint index = (uint)id;
-	int input = (int)button;
-	if (index >= sticks.size() || input >= ButtonCount)
-		return 0;
+	constexpr int RawAxisCount = JoystickHatOffset - JoystickAxisOffset;
+	if (slot < RawAxisCount)
+		return 2 + slot / 2;
+	if (slot < RawAxisCount + SDL_GAMEPAD_AXIS_LEFT_TRIGGER)
+		return (slot - RawAxisCount) / 2;
 
-	return (sticks[index].button_events[input] & 0b010) != 0;
+	return -1;
 }
 
-int GamepadGetOriginalIndex(uint id, int button, int* any = nullptr)
+struct GMStick2D
 {
-	if (button < DefinedButtonOffset || button >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
-		return -1;
+	Uint8 mode = STICK_MODE_AXIAL;
+	float x = 0;
+	float y = 0;
+	float angle = 0;      // 与 GameMaker 的 point_direction 一致：0 为右，逆时针增加
+	float magnitude = 0;
+};
 
-	int type;
-	if (button < DefinedAxisOffset)
+// 视角加速：摇杆推到边缘（距离不小于 edge）后，转动倍率在 ramp_time 秒内从 1 线性增加到 max_multiplier。
+// 摇杆的值在两个事件之间保持不变，按事件时间戳对 值 × 倍率 积分，得到每帧的转动量（值 × 秒），与帧率无关。
+struct GMLookAccel
+{
+	float ramp_time = 0;  // 秒，0 为关闭加速
+	float max_multiplier = 1;
+	float edge = 0.9f;
+
+	Uint64 timestamp = 0;  // 已积分到的时间
+	float x = 0;
+	float y = 0;
+	float held = 0;        // 在边缘停留的秒数
+	double sum_x = 0;      // 本帧的积分
+	double sum_y = 0;
+	float delta_x = 0;     // 上一帧的转动量
+	float delta_y = 0;
+
+	bool AtEdge() const
 	{
-		type = SDL_GAMEPAD_BINDTYPE_BUTTON;
-		button -= DefinedButtonOffset;
+		return ramp_time > 0 && x * x + y * y >= edge * edge;
 	}
-	else
+
+	// 在边缘停留 t 秒时倍率对时间的积分
+	double Area(double t) const
 	{
-		type = SDL_GAMEPAD_BINDTYPE_AXIS;
-		button -= DefinedAxisOffset;
+		double extra = max_multiplier - 1.0;
+		return t + extra * (t < ramp_time ? t * t / (2.0 * ramp_time) : t - ramp_time / 2.0);
 	}
 
-	for (int i = 0; i < sticks[id].binding_count; i++)
+	float Multiplier() const
 	{
-		SDL_GamepadBinding* bind = sticks[id].bindings[i];
-		if (bind->output_type != type)
-			continue;
+		return AtEdge() ? 1.0f + (max_multiplier - 1.0f) * SDL_min(held / ramp_time, 1.0f) : 1.0f;
+	}
+
+	void Advance(Uint64 t)
+	{
+		if (t <= timestamp)
+			return;
 
-		if (type == SDL_GAMEPAD_BINDTYPE_BUTTON)
+		if (timestamp == 0)
 		{
-			if (bind->output.button != button)
-				continue;
+			timestamp = t;
+			return;
 		}
-		else
+
+		double dt = (t - timestamp) / 1e9;
+		timestamp = t;
+
+		double area = dt;
+		if (AtEdge())
 		{
-			if (bind->output.axis.axis != button)
-				continue;
+			area = Area(held + dt) - Area(held);
+			held += (float)dt;
 		}
 
-		switch (bind->input_type)
-		{
-		case SDL_GAMEPAD_BINDTYPE_NONE:
-		{
-			if (any != nullptr)
-				*any = SDL_GAMEPAD_BUTTON_INVALID;
+		sum_x += x * area;
+		sum_y += y * area;
+	}
 
-			return -1;
-		}
-		case SDL_GAMEPAD_BINDTYPE_BUTTON:
-		{
-			if (any != nullptr)
-				*any = SDL_GAMEPAD_BUTTON_ANY;
+	void Set(float new_x, float new_y, Uint64 t)
+	{
+		Advance(t);
+		x = new_x;
+		y = new_y;
+		if (!AtEdge())
+			held = 0;
+	}
+
+	void EndFrame(Uint64 now)
+	{
+		Advance(now);
+		delta_x = (float)sum_x;
+		delta_y = (float)sum_y;
+		sum_x = sum_y = 0;
+	}
+};
 
-			return bind->input.button;
+// 摇杆校准：在处理事件时逐步学习每个轴的中心与范围，以及每个二维摇杆在各个方向上能推到的距离（外框形状），
+// 在死区之前修正偏离中心的原位与非圆形的外框。
+constexpr int GateBins = 32;
+constexpr float CalibrationRestWindow = 0.2f;  // 距中心不超过该值且变化很小的值视为原位
+constexpr float CalibrationRestStep = 0.02f;
+constexpr float CalibrationMinRange = 0.5f;    // 学习到的范围超过该值后才使用
+
+struct GMAxisCalibration
+{
+	bool seeded = false;
+	float center = 0;
+	float positive = 0;    // 学习到的正方向最大偏移
+	float negative = 0;    // 学习到的负方向最大偏移
+	float last = 0;        // 上一个原始值
+	float normalized = 0;  // 修正中心与范围后的值
+
+	// partner_rest 为二维摇杆另一个轴是否也在原位，避免沿轴线移动时把另一个轴的值当作中心
+	float Learn(float value, bool partner_rest = true)
+	{
+		if (!seeded)
+		{
+			seeded = true;
+			if (fabsf(value) < CalibrationRestWindow)
+				center = value;
 		}
-		case SDL_GAMEPAD_BINDTYPE_AXIS:
+
+		if (partner_rest && IsRest(value))
+			center += (value - center) * 0.05f;
+
+		last = value;
+		float offset = value - center;
+		positive = SDL_max(positive, offset);
+		negative = SDL_max(negative, -offset);
+		return Normalize(value);
+	}
+
+	bool IsRest(float value) const
+	{
+		return fabsf(value - center) < CalibrationRestWindow && fabsf(value - last) < CalibrationRestStep;
+	}
+
+	bool NearCenter() const
+	{
+		return fabsf(last - center) < CalibrationRestWindow;
+	}
+
+	float Normalize(float value)
+	{
+		float offset = value - center;
+		float range = offset >= 0
+			? (positive > CalibrationMinRange ? positive : 1.0f - center)
+			: (negative > CalibrationMinRange ? negative : 1.0f + center);
+
+		normalized = SDL_clamp(offset / SDL_max(range, 0.0001f), -1.0f, 1.0f);
+		return normalized;
+	}
+};
+
+struct GMStickGate
+{
+	std::array<float, GateBins> radius{};  // 每个方向学习到的最大距离
+
+	static float Bin(float x, float y)
+	{
+		float angle = atan2f(y, x) * (GateBins / (2.0f * SDL_PI_F));
+		return angle < 0 ? angle + GateBins : angle;
+	}
+
+	void Learn(float x, float y, float magnitude)
+	{
+		if (magnitude < CalibrationMinRange)
+			return;
+
+		int bin = (int)Bin(x, y) % GateBins;
+		radius[bin] = SDL_max(radius[bin], magnitude);
+	}
+
+	// 当前方向上外框的距离，相邻方向之间线性插值，尚未学习时为 1
+	float Radius(float x, float y) const
+	{
+		float bin = Bin(x, y);
+		int i = (int)bin % GateBins;
+		int j = (i + 1) % GateBins;
+		float a = radius[i] > CalibrationMinRange ? radius[i] : 1.0f;
+		float b = radius[j] > CalibrationMinRange ? radius[j] : 1.0f;
+		return a + (b - a) * (bin - (int)bin);
+	}
+};
+
+struct GMCalibration
+{
+	bool enabled = false;
+	bool learning = true;
+	std::array<GMAxisCalibration, AxisSlotCount> axes;
+	std::array<GMStickGate, StickCount> gates;
+};
+
+// 漂移检测：没有按钮按下、二维摇杆的两个轴都在中心附近，且值在 DriftStableTime 内保持稳定时，
+// 将死区之前的值视为原位样本，以指数加权的方式统计均值与方差，建议能够屏蔽漂移的最小死区。
+// 轻推并保持摇杆时手的抖动会超过 DriftRestStep，不会被当作原位。
+constexpr float DriftRestWindow = 0.35f;
+constexpr float DriftRestStep = 0.02f;
+constexpr Uint64 DriftStableTime = 500000000;  // 纳秒
+constexpr float DriftAlpha = 0.02f;
+constexpr Uint32 DriftMinSamples = 100;
+constexpr float DriftMinDeadzone = 0.02f;
+constexpr float DriftMaxDeadzone = 0.5f;
+
+struct GMDriftStats
+{
+	Uint32 samples = 0;
+	float mean = 0;
+	float variance = 0;
+	float anchor = 0;         // 稳定区间的起始值
+	Uint64 anchor_time = 0;   // 稳定区间的起始时间，0 表示尚未开始
+
+	void Add(float value, bool idle, Uint64 timestamp)
+	{
+		if (!idle || fabsf(value) >= DriftRestWindow || fabsf(value - anchor) >= DriftRestStep || anchor_time == 0)
 		{
-			if (any != nullptr)
-				*any = SDL_GAMEPAD_AXIS_ANY;
+			anchor = value;
+			anchor_time = timestamp;
+			return;
+		}
 
-			return JoystickAxisOffset + bind->input.axis.axis;
+		if (timestamp - anchor_time < DriftStableTime)
+			return;
+
+		if (samples++ == 0)
+		{
+			mean = value;
+			variance = 0;
+			return;
 		}
-		case SDL_GAMEPAD_BINDTYPE_HAT:	
+
+		float delta = value - mean;
+		mean += DriftAlpha * delta;
+		variance = (1.0f - DriftAlpha) * (variance + DriftAlpha * delta * delta);
+	}
+
+	// 原位偏移加上 4 倍标准差，样本不足时返回 -1
+	float Suggest() const
+	{
+		if (samples < DriftMinSamples)
+			return -1;
+
+		return SDL_clamp(fabsf(mean) + 4.0f * sqrtf(variance) + 0.01f, DriftMinDeadzone, DriftMaxDeadzone);
+	}
+};
+
+// 数字输入（原始按钮、方向键与已定义按钮）的去抖动。接受的边沿立即生效，不增加延迟；
+// 之后 window 纳秒内的边沿视为抖动而被忽略。被忽略的边沿若是最终状态，窗口结束后在 gamepad_update 末尾补发。
+struct GMDebounce
+{
+	Uint64 window = 0;  // 纳秒，0 表示关闭
+	std::array<Uint64, DefinedAxisOffset> last_edge{};  // 最后一次接受的边沿的时间戳
+	std::array<Sint8, DefinedAxisOffset> deferred;      // 被忽略的边沿之后设备报告的状态，-1 表示没有
+	bool pending = false;  // 有被忽略的边沿，需要在窗口结束后检查
+
+	GMDebounce() { deferred.fill(-1); }
+};
+
+// One-Euro 滤波器，按 SDL 事件时间戳计算采样间隔，与 GameMaker 的帧率无关
+struct GMOneEuroFilter
+{
+	bool seeded = false;
+	Uint64 timestamp = 0;
+	float input = 0;       // 上一个输入值
+	float value = 0;       // 滤波后的值
+	float derivative = 0;  // 平滑后的变化速度（每秒）
+
+	// 上一次采样之前的状态，同一时间戳再次采样（例如同一报告中的 X 与 Y）时替换上一次采样
+	Uint64 prev_timestamp = 0;
+	float prev_input = 0;
+	float prev_value = 0;
+	float prev_derivative = 0;
+
+	static float Alpha(float cutoff, float dt)
+	{
+		float tau = 1.0f / (2.0f * SDL_PI_F * cutoff);
+		return 1.0f / (1.0f + tau / dt);
+	}
+
+	float Filter(float x, Uint64 t, const GMAxisConfig& config)
+	{
+		if (!seeded)
 		{
-			if (any != nullptr)
-				*any = SDL_GAMEPAD_BUTTON_ANY;
+			seeded = true;
+			timestamp = prev_timestamp = t;
+			input = prev_input = x;
+			value = prev_value = x;
+			derivative = prev_derivative = 0;
+			return value;
+		}
 
-			auto indexList = GamepadGetHat(bind->input.hat.hat_mask, 0, 1, 2, 3);
-			return JoystickHatOffset + bind->input.hat.hat * 4 + indexList.at(0);
+		if (t > timestamp)
+		{
+			prev_timestamp = timestamp;
+			prev_input = input;
+			prev_value = value;
+			prev_derivative = derivative;
+			timestamp = t;
 		}
+
+		input = x;
+		if (timestamp == prev_timestamp)
+		{
+			value = x;
+			return value;
 		}
-	}
 
-	return -1;
-}
+		float dt = (timestamp - prev_timestamp) / 1e9f;
+		float dx = (x - prev_input) / dt;
+		derivative = prev_derivative + Alpha(SDL_max(config.filter_d_cutoff, 0.001f), dt) * (dx - prev_derivative);
 
-expReal gamepad_button_press(GMReal id, GMReal button)
-{
-	uint index = (uint)id;
-	int input = (int)button;
-	if (index >= sticks.size())
-		return 0;
+		float cutoff = config.filter_min_cutoff + SDL_max(config.filter_beta, 0.0f) * fabsf(derivative);
+		value = prev_value + Alpha(cutoff, dt) * (x - prev_value);
+		return value;
+	}
+};
 
-	if (input < 0 || input >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
-		return 0;
+// 方向量化：将左摇杆、右摇杆或十字键（方向键 0 与已定义的十字键按钮）转换为 4 个或 8 个方向，
+// 结果作为输入值 135 - 146，与其他按钮一样产生按下、按住与放开事件。8 方向时斜向同时按住两个方向。
+// 当前方向的扇区向两侧扩大 hysteresis 度，避免在扇区边界（例如斜向）来回切换。
+enum DirectionSource
+{
+	DIRECTION_SOURCE_LEFT_STICK,
+	DIRECTION_SOURCE_RIGHT_STICK,
+	DIRECTION_SOURCE_DPAD
+};
 
-	sticks[index].button_events[input] |= 0b101;
-	sticks[index].button_events[SDL_GAMEPAD_ANY] |= 0b101;
+struct GMDirection
+{
+	Uint8 ways = 8;           // 4 或 8，0 为关闭
+	float hysteresis = 10;    // 度
+	float threshold = 0.5f;   // 摇杆距离不小于该值时产生方向，低于其 3/4 时放开
+	int sector = -1;          // 当前的扇区，从右方开始逆时针编号，-1 表示没有方向
+	bool cleared = false;     // 被 gamepad_clear 清除，回到原位之前不产生方向
+
+	// angle 与 point_direction 一致（度），返回新的扇区
+	int Quantize(float angle, float magnitude)
+	{
+		if (ways == 0 || magnitude < (sector < 0 ? threshold : threshold * 0.75f))
+		{
+			sector = -1;
+			return sector;
+		}
 
-	// 如果是受支持的手柄且传入游戏手柄按钮常量，则原始索引也会打开事件
-	int any_index;
-	int result = GamepadGetOriginalIndex(index, input, &any_index);
-	if (result >= 0)
-		sticks[index].button_events[result] |= 0b101;
+		float width = 360.0f / ways;
+		if (sector >= 0)
+		{
+			float offset = fmodf(angle - sector * width + 540.0f, 360.0f) - 180.0f;
+			if (fabsf(offset) <= width / 2 + SDL_min(hysteresis, width * 0.45f))
+				return sector;
+		}
 
-	if (any_index != SDL_GAMEPAD_BUTTON_INVALID)
-		sticks[index].button_events[any_index] |= 0b101;
-		
-	return 1;
-}
+		sector = (int)((angle + width / 2) / width) % ways;
+		return sector;
+	}
+};
 
-expReal gamepad_button_release(GMReal id, GMReal button)
+// 摇杆值对时间的积分：值在两个事件之间保持不变，按事件时间戳累加面积，帧末除以帧的时长得到平均值。
+// 与 GMLookAccel 的积分方式相同，不含加速倍率。
+struct GMAxisIntegrator
 {
-	uint index = (uint)id;
-	int input = (int)button;
-	if (index >= sticks.size())
-		return 0;
+	Uint64 start = 0;      // 本帧积分的起点
+	Uint64 timestamp = 0;  // 已积分到的时间
+	float value = 0;
+	double area = 0;       // 值 × 纳秒
+	float average = 0;     // 上一帧的平均值
 
-	if (input < 0 || input >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
-		return 0;
+	void Advance(Uint64 t)
+	{
+		if (t <= timestamp)
+			return;
 
-	auto event = &sticks[index].button_events[input];
-	*event &= 0b011;  // 关闭按钮事件
-	*event |= 0b010;  // 打开按钮放开事件
+		if (timestamp == 0)
+			start = t;
+		else
+			area += (double)value * (t - timestamp);
 
-	event = &sticks[index].button_events[SDL_GAMEPAD_ANY];
-	*event &= 0b011;
-	*event |= 0b010;
+		timestamp = t;
+	}
 
-	// 如果是受支持的手柄且传入游戏手柄按钮常量，则原始索引也会打开事件
-	int any_index;
-	int result = GamepadGetOriginalIndex(index, input, &any_index);
-	if (result >= 0)
+	void Set(float new_value, Uint64 t)
 	{
-		event = &sticks[index].button_events[result];
-		*event &= 0b011;
-		*event |= 0b010;
+		Advance(t);
+		value = new_value;
 	}
 
-	if (any_index != SDL_GAMEPAD_BUTTON_INVALID)
+	void EndFrame(Uint64 now)
 	{
-		event = &sticks[index].button_events[any_index];
-		*event &= 0b011;
-		*event |= 0b010;
+		Advance(now);
+		average = timestamp > start ? (float)(area / (timestamp - start)) : value;
+		start = timestamp;
+		area = 0;
 	}
+};
 
-	return 1;
-}
+struct GMGamepad
+{
+	// 当接入 SDL3 支持的手柄时，gamepad 和 joystick 都不为 nullptr；
+	// 当接入 SDL3 不支持的手柄时，gamepad 为 nullptr，joystick 不为 nullptr。
+	// 永远不会出现 gamepad 不为 nullptr，joystick 为 nullptr 的情况。
+	SDL_Gamepad* gamepad;
+	SDL_Joystick* joystick;
 
-expReal gamepad_set_vibration(GMReal id, GMReal low, GMReal high, GMReal len)
+	SDL_GamepadBinding** bindings = nullptr;
+	int binding_count = 0;
+	bool validation_pending = false;  // 查询表与能力来自能力缓存，尚未验证
+	GMBindingTable binding_table;
+
+	double deadzone = 0.05;
+	std::array<char, ButtonCount> button_events;
+
+	// 每个摇杆槽位的处理配置、编译后的处理函数，以及处理后的值（在处理事件时更新）
+	std::array<GMAxisConfig, AxisSlotCount> axis_config;
+	std::vector<GMAxisKernel> axis_kernels;
+	std::array<float, AxisSlotCount> axis_values;
+	std::array<float, AxisSlotCount> axis_raw;  // 死区之前（经过校准）的归一化值
+	GMCalibration calibration;
+	std::array<GMDriftStats, AxisSlotCount> drift;
+	bool auto_deadzone = false;  // 自动将内死区调整为建议值
+	std::array<float, AxisSlotCount> drift_deadzone;  // 自动死区，大于 0 时代替配置的内死区，不保存至设备配置
+	std::array<GMOneEuroFilter, AxisSlotCount> filters;
+	std::array<float, AxisSlotCount> axis_filtered;
+	std::array<Uint64, AxisSlotCount> axis_timestamps;  // 每个槽位最后一个事件的时间戳
+	std::array<GMAxisIntegrator, AxisSlotCount> integrators;
+
+	std::array<GMStick2D, StickCount> sticks2d;
+	std::array<GMLookAccel, StickCount> look;
+	std::array<GMDirection, DirectionSourceCount> directions;
+	Uint32 sticks2d_dirty = 0;  // 第 n 位表示二维摇杆 n 的输入在本帧中改变了
+
+	GMDebounce debounce;
+
+	GMDeviceInfo info;
+	GMDeviceStrings strings;
+	GMInputMasks masks;  // 由 button_events 生成，供多输入查询使用
+	GMLastInput last_pressed;
+	GMSoftMapping soft;
+
+	// 从 SDL 事件时间戳到 gamepad_update 返回的延迟
+	GMLatencyHistogram latency;
+	GMReportStats report;
+};
+
+std::vector<GMGamepad> sticks;
+SDL_Event my_event;
+
+bool gp_updated = false;
+bool enumerate_pending = true;
+
+// 运行时性能统计项，作为 gamepad_get_stat 的 stat 参数
+// 0 - 10: 各类型事件的处理数量
+enum GMStat
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	GM_STAT_GAMEPAD_BUTTON_DOWN,
+	GM_STAT_GAMEPAD_BUTTON_UP,
+	GM_STAT_GAMEPAD_AXIS_MOTION,
+	GM_STAT_JOYSTICK_BUTTON_DOWN,
+	GM_STAT_JOYSTICK_BUTTON_UP,
+	GM_STAT_JOYSTICK_AXIS_MOTION,
+	GM_STAT_JOYSTICK_HAT_MOTION,
+	GM_STAT_DEVICE_ADDED,
+	GM_STAT_DEVICE_REMOVED,
+	GM_STAT_EVENT_OTHER,
+	GM_STAT_EVENT_TOTAL,
+	GM_STAT_UPDATE_TIME,      // gamepad_update 耗时（导出时换算为微秒）
+	GM_STAT_QUEUE_DEPTH,      // 开始处理事件时事件队列的深度
+	GM_STAT_DEVICES_OPENED,
+	GM_STAT_DEVICES_CLOSED,
+	GM_STAT_MAPPING_LOOKUPS,  // 按键映射查询次数
+	GM_STAT_ALLOCATIONS,      // 扩展自身的堆分配次数，需开启分配统计
+	GM_STAT_SDL_ALLOCATIONS,  // SDL 的堆分配次数，需开启分配统计
+	GM_STAT_STEADY_ALLOCATION_FRAMES,  // 没有热插拔却发生了堆分配的帧数，正常应为 0
+	GM_STAT_COUNT
+};
 
-	Uint16 low_strength = (Uint16)(SDL_clamp(low * 65535, 0, 65535));
-	Uint16 high_strength = (Uint16)(SDL_clamp(high * 65535, 0, 65535));
-	Uint32 len_ms = (Uint32)(std::max(0.0, len * 1000));
+// 统计的取值方式，作为 gamepad_get_stat 的 kind 参数
+enum GMStatKind
+{
+	GM_STAT_KIND_LAST,     // 上一帧
+	GM_STAT_KIND_TOTAL,    // 累计
+	GM_STAT_KIND_MAX,      // 单帧最大值
+	GM_STAT_KIND_AVERAGE   // 每帧平均值
+};
 
-	return SDL_RumbleJoystick(sticks[(uint)id].joystick, low_strength, high_strength, len_ms);
+// 一帧指两次 gamepad_update 返回之间的时间，期间 GML 调用导出函数产生的统计也计入该帧。
+struct GMStats
+{
+	std::array<Uint64, GM_STAT_COUNT> current{};
+	std::array<Uint64, GM_STAT_COUNT> last{};
+	std::array<Uint64, GM_STAT_COUNT> total{};
+	std::array<Uint64, GM_STAT_COUNT> max{};
+	Uint64 frames = 0;
+};
+
+GMStats stats;
+
+inline void StatAdd(GMStat stat, Uint64 value = 1)
+{
+	stats.current[stat] += value;
 }
 
-expReal gamepad_set_color(GMReal id, GMReal col)
+inline void StatCountEvent(Uint32 type)
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	switch (type)
+	{
+	case SDL_EVENT_GAMEPAD_BUTTON_DOWN: StatAdd(GM_STAT_GAMEPAD_BUTTON_DOWN); break;
+	case SDL_EVENT_GAMEPAD_BUTTON_UP: StatAdd(GM_STAT_GAMEPAD_BUTTON_UP); break;
+	case SDL_EVENT_GAMEPAD_AXIS_MOTION: StatAdd(GM_STAT_GAMEPAD_AXIS_MOTION); break;
+	case SDL_EVENT_JOYSTICK_BUTTON_DOWN: StatAdd(GM_STAT_JOYSTICK_BUTTON_DOWN); break;
+	case SDL_EVENT_JOYSTICK_BUTTON_UP: StatAdd(GM_STAT_JOYSTICK_BUTTON_UP); break;
+	case SDL_EVENT_JOYSTICK_AXIS_MOTION: StatAdd(GM_STAT_JOYSTICK_AXIS_MOTION); break;
+	case SDL_EVENT_JOYSTICK_HAT_MOTION: StatAdd(GM_STAT_JOYSTICK_HAT_MOTION); break;
+	case SDL_EVENT_JOYSTICK_ADDED:
+	case SDL_EVENT_GAMEPAD_ADDED: StatAdd(GM_STAT_DEVICE_ADDED); break;
+	case SDL_EVENT_JOYSTICK_REMOVED:
+	case SDL_EVENT_GAMEPAD_REMOVED: StatAdd(GM_STAT_DEVICE_REMOVED); break;
+	default: StatAdd(GM_STAT_EVENT_OTHER); break;
+	}
 
-	int color = (int)col;
-	Uint8 b = (Uint8)((color >> 16) & 0xFF);
-	Uint8 g = (Uint8)((color >> 8) & 0xFF);
-	Uint8 r = (Uint8)(color & 0xFF);
+	StatAdd(GM_STAT_EVENT_TOTAL);
+}
 
-	return SDL_SetJoystickLED(sticks[(uint)id].joystick, r, g, b);
+// 堆分配统计。SDL 的分配通过 SDL_SetMemoryFunctions 接管，扩展自身的分配通过替换 operator new 接管。
+// 分配函数会在 SDL 的线程与后台写入、映射监视线程中调用，所以开关与计数都使用原子变量；
+// 只统计调用 gamepad_update 的线程在 gamepad_update 期间的分配。调试版本默认开启，稳定帧有分配时输出警告。
+// 不使用断言：SDL 的事件队列与 HIDAPI 驱动在正常运行中也会分配，这些分配扩展无法避免。
+#ifdef _DEBUG
+SDL_AtomicInt alloc_tracking = { 1 };
+#else
+SDL_AtomicInt alloc_tracking;
+#endif
+SDL_AtomicInt allocations;
+SDL_AtomicInt sdl_allocations;
+thread_local bool alloc_in_update = false;
+
+inline bool AllocCounted()
+{
+	return alloc_in_update && SDL_GetAtomicInt(&alloc_tracking) != 0;
 }
 
-expReal gamepad_axis_count(GMReal id)
+// 在 gamepad_update 期间开启当前线程的分配统计
+struct AllocScope
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	AllocScope() { alloc_in_update = true; }
+	~AllocScope() { alloc_in_update = false; }
+};
 
-	return SDL_GetNumJoystickAxes(sticks[(uint)id].joystick);
-}
+SDL_malloc_func sdl_malloc;
+SDL_calloc_func sdl_calloc;
+SDL_realloc_func sdl_realloc;
+SDL_free_func sdl_free;
 
-expReal gamepad_button_count(GMReal id)
+static void* SDLCALL TrackedMalloc(size_t size)
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	if (AllocCounted())
+		SDL_AddAtomicInt(&sdl_allocations, 1);
 
-	return SDL_GetNumJoystickButtons(sticks[(uint)id].joystick);
+	return sdl_malloc(size);
 }
 
-expReal gamepad_hat_count(GMReal id)
+static void* SDLCALL TrackedCalloc(size_t nmemb, size_t size)
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	if (AllocCounted())
+		SDL_AddAtomicInt(&sdl_allocations, 1);
 
-	return SDL_GetNumJoystickHats(sticks[(uint)id].joystick);
+	return sdl_calloc(nmemb, size);
 }
 
-expReal gamepad_get_inputs_index(GMReal id, GMReal button)
+static void* SDLCALL TrackedRealloc(void* mem, size_t size)
 {
-	uint index = (uint)id;
-	int input = (int)button;
-	if (index >= sticks.size() || input >= ButtonCount)
-		return -1;
+	if (AllocCounted())
+		SDL_AddAtomicInt(&sdl_allocations, 1);
 
-	return GamepadGetOriginalIndex(index, input);
+	return sdl_realloc(mem, size);
 }
 
-expString gamepad_get_mapping(GMReal id)
+static void SDLCALL TrackedFree(void* mem)
 {
-	if (id < 0 || id >= sticks.size())
-		return "device index out of range";
+	sdl_free(mem);
+}
 
-	if (sticks[(uint)id].gamepad == nullptr)
-		return "no mapping";
+// 必须在 SDL 进行任何分配之前调用
+void InstallMemoryFunctions()
+{
+	if (sdl_malloc != nullptr)
+		return;
 
-	GMString mapping = SDL_GetGamepadMapping(sticks[(uint)id].gamepad);
-	if (mapping == nullptr)
-		return "no mapping";
+	SDL_GetOriginalMemoryFunctions(&sdl_malloc, &sdl_calloc, &sdl_realloc, &sdl_free);
+	SDL_SetMemoryFunctions(TrackedMalloc, TrackedCalloc, TrackedRealloc, TrackedFree);
+}
+
+void* operator new(size_t size)
+{
+	if (AllocCounted())
+		SDL_AddAtomicInt(&allocations, 1);
 
-	return mapping;
+	return malloc(size != 0 ? size : 1);
 }
 
-expReal gamepad_test_mapping(GMReal id, GMString mapping)
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* mem) noexcept { free(mem); }
+void operator delete[](void* mem) noexcept { free(mem); }
+void operator delete(void* mem, size_t) noexcept { free(mem); }
+void operator delete[](void* mem, size_t) noexcept { free(mem); }
+
+// 将本帧的堆分配次数计入统计。hotplug 为本帧有设备接入、断开或配置改变（映射、能力验证、文件写入），
+// 其他帧不应分配任何内存。
+void StatAddAllocations(bool hotplug)
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	if (SDL_GetAtomicInt(&alloc_tracking) == 0)
+		return;
 
-	SDL_JoystickID joy_id = SDL_GetJoystickID(sticks[(uint)id].joystick);
-	bool result = SDL_SetGamepadMapping(joy_id, mapping);
-	if (!result)
-		return 0;
+	int own = SDL_SetAtomicInt(&allocations, 0);
+	int sdl = SDL_SetAtomicInt(&sdl_allocations, 0);
+	StatAdd(GM_STAT_ALLOCATIONS, own);
+	StatAdd(GM_STAT_SDL_ALLOCATIONS, sdl);
 
-	if (sticks[(uint)id].gamepad == nullptr)
+	hotplug |= stats.current[GM_STAT_DEVICE_ADDED] != 0 || stats.current[GM_STAT_DEVICE_REMOVED] != 0;
+	if (!hotplug && own + sdl > 0)
 	{
-		// 尝试打开手柄
-		SDL_Gamepad* gamepad = SDL_OpenGamepad(joy_id);
-		if (gamepad == nullptr)
-			return 0;
+		StatAdd(GM_STAT_STEADY_ALLOCATION_FRAMES);
+#ifdef _DEBUG
+		SDL_LogWarn(SDL_LOG_CATEGORY_INPUT, "GMGamepad: steady-state frame allocated %d (extension) + %d (SDL) times", own, sdl);
+#endif
+	}
+}
 
-		sticks[(uint)id].gamepad = gamepad;
+// 结束当前帧的统计，并计入累计值
+void StatEndFrame()
+{
+	for (uint i = 0; i < GM_STAT_COUNT; i++)
+	{
+		stats.last[i] = stats.current[i];
+		stats.total[i] += stats.current[i];
+		stats.max[i] = std::max(stats.max[i], stats.current[i]);
+		stats.current[i] = 0;
 	}
 
-	return 1;
+	stats.frames++;
 }
 
-expReal gamepad_remove_mapping(GMReal id)
+// 本帧待统计延迟的事件。事件的状态在 gamepad_update 返回时才对游戏可见，
+// 所以先记下时间戳，在返回前统一计入直方图。
+struct GMPendingLatency
 {
-	if (id < 0 || id >= sticks.size())
-		return 0;
+	uint index;
+	Uint64 timestamp;
+};
 
-	SDL_JoystickID joy_id = SDL_GetJoystickID(sticks[(uint)id].joystick);
-	return SDL_SetGamepadMapping(joy_id, nullptr);
-}
+constexpr uint PendingLatencyCapacity = 256;
+std::array<GMPendingLatency, PendingLatencyCapacity> pending_latency;
+uint pending_latency_count = 0;
 
-int GetGamepadID(SDL_JoystickID id)
+inline void LatencyQueue(uint index, Uint64 timestamp)
 {
-	SDL_Gamepad* joy = SDL_GetGamepadFromID(id);
-	for (uint i = 0; i < sticks.size(); i++)
+	// 缓冲区已满时直接以当前时间计入，此时延迟会略微偏小
+	if (pending_latency_count == PendingLatencyCapacity)
 	{
-		if (sticks[i].gamepad == joy)
-			return i;
+		Uint64 now = SDL_GetTicksNS();
+		sticks[index].latency.Add(now > timestamp ? now - timestamp : 0);
+		return;
 	}
 
-	return -1;
+	pending_latency[pending_latency_count++] = { index, timestamp };
 }
 
-int GetJoystickID(SDL_JoystickID id)
+void LatencyFlush()
 {
-	SDL_Joystick* joy = SDL_GetJoystickFromID(id);
-	for (uint i = 0; i < sticks.size(); i++)
+	Uint64 now = SDL_GetTicksNS();
+	for (uint i = 0; i < pending_latency_count; i++)
 	{
-		if (sticks[i].joystick == joy)
-			return i;
+		const GMPendingLatency& pending = pending_latency[i];
+		if (pending.index < sticks.size())
+			sticks[pending.index].latency.Add(now > pending.timestamp ? now - pending.timestamp : 0);
 	}
 
-	return -1;
+	pending_latency_count = 0;
 }
 
-expReal gamepad_clear(GMReal id)
+// 根据 button_events 重新生成按钮状态位图，在按钮事件改变后调用
+void GamepadSyncMasks(GMGamepad& stick)
 {
-	uint index = (uint)id;
-	if (index >= sticks.size())
-		return 0;
-
+	GMInputMasks& masks = stick.masks;
+	masks = GMInputMasks();
 	for (uint i = 0; i < ButtonCount; i++)
-		sticks[index].button_events[i] = 0;
+	{
+		char event = stick.button_events[i];
+		if (event == 0)
+			continue;
 
-	return 1;
+		Uint32 bit = 1u << (i % 32);
+		if ((event & 0b100) != 0)
+			masks.held[i / 32] |= bit;
+
+		if ((event & 0b001) != 0)
+			masks.pressed[i / 32] |= bit;
+
+		if ((event & 0b010) != 0)
+			masks.released[i / 32] |= bit;
+	}
 }
 
-expReal gamepad_update()
+// 所有手柄中最近一次按下的输入。手柄以 SDL_JoystickID 记录，查询时再换算为下标，
+// 这样其他手柄断开导致下标变化后仍然有效。
+GMLastInput last_active_input;
+SDL_JoystickID last_active_device = 0;
+
+// 在事件循环中记录按下的输入，ANY 输入值不会被记录
+inline void RecordPress(uint index, int code, Uint64 timestamp)
 {
-	bool change = false;
-	SDL_UpdateGamepads();
+	GMGamepad& stick = sticks[index];
+	stick.last_pressed = { code, timestamp };
+	last_active_input = { code, timestamp };
+	last_active_device = stick.info.instance_id;
+}
 
-	// 检查当前已连接的游戏手柄，并释放所有已断开连接的手柄。
-	for (int i = sticks.size() - 1; i >= 0; --i)
-	{
-		if (sticks[i].gamepad == nullptr)
-		{
-			// 判断不受支持的手柄的链接情况
-			if (!SDL_JoystickConnected(sticks[i].joystick))
-			{
-				SDL_CloseJoystick(sticks[i].joystick);
-				sticks.erase(sticks.begin() + i);
-				change = true;
-			}
-		}
-		else
-		{
-			// 判断受支持的手柄的链接情况
-			if (!SDL_GamepadConnected(sticks[i].gamepad))
-			{
-				SDL_CloseGamepad(sticks[i].gamepad);
-				if (sticks[i].bindings != nullptr)
-					SDL_free(sticks[i].bindings);
+// 手柄是否有任意按钮、方向键或摇杆处于按下状态
+inline bool GamepadIsActive(const GMGamepad& stick)
+{
+	if ((stick.button_events[SDL_GAMEPAD_ANY] & 0b100) != 0)
+		return true;
 
-				sticks.erase(sticks.begin() + i);
-				change = true;
-			}
-		}
+	for (uint i = JoystickAxisOffset; i < JoystickHatOffset; i++)
+	{
+		if ((stick.button_events[i] & 0b100) != 0)
+			return true;
 	}
 
-	// 获取硬件上已经连接的手柄数量
-	int count;
-	SDL_JoystickID* ids = SDL_GetJoysticks(&count);
-	if (ids == nullptr)
-		return -1;
+	return false;
+}
 
-	if ((int)sticks.size() < count)  // a new stick was attached, find it and give it a slot
-	{
-		for (int i = 0; i < count; i++)
-		{
-			bool found = false;
+// 在事件改变按钮状态之前调用，统计延迟与上报间隔
+inline void TrackInputEvent(uint index, Uint64 timestamp)
+{
+	LatencyQueue(index, timestamp);
+	sticks[index].report.Add(timestamp, GamepadIsActive(sticks[index]));
+}
 
-			SDL_Joystick* newJoy = nullptr;
-			SDL_Gamepad* newGamepad = SDL_OpenGamepad(ids[i]);
-			if (newGamepad == nullptr)
-			{
-				newJoy = SDL_OpenJoystick(ids[i]);
-				if (newJoy == nullptr)
-					continue;
-			}
-			else
-				newJoy = SDL_GetGamepadJoystick(newGamepad);
+// 输入管线的追踪记录，保存在固定大小的环形缓冲区中，写满后覆盖最旧的记录
+struct GMTraceSpan
+{
+	const char* name;  // 只能指向静态字符串
+	Uint64 begin;      // 纳秒，与 SDL_GetTicksNS 同一时间轴
+	Uint64 end;
+};
 
-			// 检查新手柄是否已经存在于列表中
-			SDL_JoystickID id = SDL_GetJoystickID(newJoy);
-			for (uint j = 0; j < sticks.size(); j++)
-			{
-				if (id == SDL_GetJoystickID(sticks[j].joystick))
-				{
-					found = true;
-					break;
-				}
-			}
+constexpr uint TraceCapacity = 4096;
 
-			if (found)  // 重复添加的会被删除
-			{
-				if (newGamepad == nullptr)
-					SDL_CloseJoystick(newJoy);
-				else
-					SDL_CloseGamepad(newGamepad);
+struct GMTrace
+{
+	bool enabled = false;
+	uint head = 0;
+	uint count = 0;
+	std::array<GMTraceSpan, TraceCapacity> spans;
+};
 
-				continue;
-			}
-			else  // 新手柄会被添加至列表中
-			{
-				int c = 0;
-				SDL_GamepadBinding** bindings = nullptr;
-				if (newGamepad != nullptr)
-					bindings = SDL_GetGamepadBindings(newGamepad, &c);
+GMTrace trace;
 
-				sticks.push_back({ newGamepad, newJoy, bindings, c });
-				change = true;
-			}
-		}
-	}
+inline void TraceRecord(const char* name, Uint64 begin, Uint64 end)
+{
+	trace.spans[trace.head] = { name, begin, end };
+	trace.head = (trace.head + 1) % TraceCapacity;
+	if (trace.count < TraceCapacity)
+		trace.count++;
+}
 
-	SDL_free(ids);
+// 在作用域内记录一段追踪，未开启追踪时只有一次分支判断的开销
+struct TraceScope
+{
+	const char* name;
+	Uint64 begin;
 
-	// 重置按钮事件
-	// 位数（从右至左）代表的含义：1.按钮按下事件  2.按钮放开事件  3.按钮事件
-	for (uint i = 0; i < sticks.size(); i++)
+	TraceScope(const char* name) : name(name), begin(trace.enabled ? SDL_GetTicksNS() : 0) {}
+	~TraceScope() { End(); }
+
+	// 提前结束记录，用于按顺序划分的阶段
+	void End()
 	{
-		for (uint j = 0; j < ButtonCount; j++)
-			sticks[i].button_events[j] &= 0b100;  // 不清除按钮事件(3)
+		if (trace.enabled && begin != 0)
+			TraceRecord(name, begin, SDL_GetTicksNS());
+
+		begin = 0;
 	}
+};
 
-	while (SDL_PollEvent(&my_event))
+inline double lerp(double fromA, double fromB, double toA, double toB, double value)
+{
+	return ((value - fromA) / (fromB - fromA)) * (toB - toA) + toA;
+}
+
+#define sign(x) ((x > 0) - (x < 0))
+
+// 方向键的方向索引：0.上  1.下  2.左  3.右
+enum HatDirection
+{
+	HAT_DIRECTION_UP,
+	HAT_DIRECTION_DOWN,
+	HAT_DIRECTION_LEFT,
+	HAT_DIRECTION_RIGHT
+};
+
+// 返回方向键按下方向的位掩码，第 n 位对应方向索引 n
+inline int GamepadGetHat(int hatMask)
+{
+	constexpr int up = 1 << HAT_DIRECTION_UP;
+	constexpr int down = 1 << HAT_DIRECTION_DOWN;
+	constexpr int left = 1 << HAT_DIRECTION_LEFT;
+	constexpr int right = 1 << HAT_DIRECTION_RIGHT;
+
+	switch (hatMask)
 	{
-		switch (my_event.type)
-		{
-			// Gamepad
-			case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
-			{
-				int joyid = GetGamepadID(my_event.gbutton.which);
-				if (joyid < 0)
-					break;
+	case SDL_HAT_UP:  return up;
+	case SDL_HAT_DOWN: return down;
+	case SDL_HAT_LEFT: return left;
+	case SDL_HAT_RIGHT: return right;
+	case SDL_HAT_LEFTUP: return up | left;
+	case SDL_HAT_LEFTDOWN: return down | left;
+	case SDL_HAT_RIGHTUP: return up | right;
+	case SDL_HAT_RIGHTDOWN: return down | right;
+	default: return 0;
+	}
+}
 
-				sticks[joyid].button_events[my_event.gbutton.button + DefinedButtonOffset] |= 0b101;
-			}
-			break;
+inline const char* NotNull(const char* str, const char* fallback = "")
+{
+	return str != nullptr ? str : fallback;
+}
 
-			case SDL_EVENT_GAMEPAD_BUTTON_UP:
-			{
-				int joyid = GetGamepadID(my_event.gbutton.which);
-				if (joyid < 0)
-					break;
+// 获取每个设备各自的字符串（序列号、路径）并生成汇总信息，能力缓存命中时也需要调用
+void GamepadCacheInstanceStrings(GMGamepad& stick)
+{
+	GMDeviceStrings& strings = stick.strings;
+	strings.serial = NotNull(SDL_GetJoystickSerial(stick.joystick));
+	strings.path = NotNull(SDL_GetJoystickPath(stick.joystick));
 
-				auto buttonEvent = &sticks[joyid].button_events[my_event.gbutton.button + DefinedButtonOffset];
-				*buttonEvent &= 0b011;  // 关闭按钮事件
-				*buttonEvent |= 0b010;  // 打开按钮放开事件
-			}
+	SDL_GUID guid = stick.info.guid;
+	bool error = true;
+	for (uint i = 0; i < 16; ++i)
+	{
+		if (guid.data[i] != 0)
+		{
+			error = false;
 			break;
+		}
+	}
 
-			case SDL_EVENT_GAMEPAD_AXIS_MOTION:
-			{
-				int joyid = GetGamepadID(my_event.gbutton.which);
-				if (joyid < 0)
-					break;
-			
-				GMReal value = (GMReal)my_event.gaxis.value / 32767;
-				if (fabs(value) < sticks[joyid].deadzone)
-					value = 0;
-				else
-					value = lerp(sticks[joyid].deadzone, 1, 0, 1, fabs(value)) * sign(value);
+	if (error)
+		strings.guid = "none";
+	else
+	{
+		char guid_str[33];
+		SDL_GUIDToString(guid, guid_str, sizeof(guid_str));
+		strings.guid = guid_str;
+	}
 
-				// 由于 SDL3 中 SDL_EVENT_JOYSTICK_AXIS_MOTION 事件的 my_event.jaxis.value 固定为 [-32768, 32767]
-				// 导致摇杆和扳机键的行为不一致，所以在 SDL_EVENT_GAMEPAD_AXIS_MOTION 事件中执行 ANY 操作。
-				auto buttonEvent = &sticks[joyid].button_events[my_event.gaxis.axis + DefinedAxisOffset];
-				auto anyAxisEvent = &sticks[joyid].button_events[SDL_GAMEPAD_AXIS_ANY];
-				auto anyEvent = &sticks[joyid].button_events[SDL_GAMEPAD_ANY];
+	const GMDeviceInfo& info = stick.info;
+	char buffer[192];
+	SDL_snprintf(buffer, sizeof(buffer), "%d,%d,%d,%d,%u,%u,%u,%d,%u,%u,%s,%u",
+		info.axis_count, info.button_count, info.hat_count, info.type,
+		info.vendor, info.product, info.version, info.connection_state,
+		info.button_mask, info.axis_mask, strings.guid.c_str(), (unsigned int)info.instance_id);
+	strings.info = buffer;
+}
 
-				if (fabs(value) > 0 && (*buttonEvent & 0b100) == 0)  // 摇杆刚开始运动
-				{
-					*buttonEvent |= 0b101;  // 打开按钮按下事件，并打开摇杆状态
-					*anyAxisEvent |= 0b101;
-					*anyEvent |= 0b101;
-				}
-				else if (value == 0 && (*buttonEvent & 0b100) != 0)  // 摇杆结束运动，回到原位
-				{
-					*buttonEvent &= 0b011;  // 关闭摇杆状态
-					*buttonEvent |= 0b010;  // 打开按钮放开事件
+// 获取设备的所有字符串，名称、映射与类型名称会保存至能力缓存
+void GamepadCacheStrings(GMGamepad& stick)
+{
+	GMDeviceStrings& strings = stick.strings;
+	strings.name = NotNull(SDL_GetJoystickName(stick.joystick));
+	strings.mapping = "no mapping";
+	strings.type_name = "unknown";
+	if (stick.gamepad != nullptr)
+	{
+		StatAdd(GM_STAT_MAPPING_LOOKUPS);
+		char* mapping = SDL_GetGamepadMapping(stick.gamepad);
+		if (mapping != nullptr)
+		{
+			strings.mapping = mapping;
+			SDL_free(mapping);
+		}
 
-					*anyAxisEvent &= 0b011;
-					*anyAxisEvent |= 0b010;
+		strings.type_name = NotNull(SDL_GetGamepadStringForType((SDL_GamepadType)stick.info.type), "unknown");
+	}
 
-					*anyEvent &= 0b011;
-					*anyEvent |= 0b010;
-				}
-			}
-			break;
+	GamepadCacheInstanceStrings(stick);
+}
 
-			// Joystick
-			// 因为在 SDL3 中，不支持的手柄会发出 SDL_EVENT_JOYSTICK_* 事件，支持的手柄会两个类型的事件都会发出，
-			// 所以 SDL_GAMEPAD_BUTTON_ANY 和 SDL_GAMEPAD_ANY 事件在此设定，保证泛用性。
-			case SDL_EVENT_JOYSTICK_BUTTON_DOWN:
-			{
-				int joyid = GetJoystickID(my_event.jbutton.which);
-				if (joyid < 0)
-					break;
+// 获取设备的固定信息，在手柄接入或映射改变时调用
+void GamepadCacheInfo(GMGamepad& stick)
+{
+	GMDeviceInfo& info = stick.info;
+	info.instance_id = SDL_GetJoystickID(stick.joystick);
+	info.guid = SDL_GetJoystickGUID(stick.joystick);
+	info.axis_count = SDL_GetNumJoystickAxes(stick.joystick);
+	info.button_count = SDL_GetNumJoystickButtons(stick.joystick);
+	info.hat_count = SDL_GetNumJoystickHats(stick.joystick);
+	info.vendor = SDL_GetJoystickVendor(stick.joystick);
+	info.product = SDL_GetJoystickProduct(stick.joystick);
+	info.version = SDL_GetJoystickProductVersion(stick.joystick);
+	info.firmware = SDL_GetJoystickFirmwareVersion(stick.joystick);
+	info.connection_state = SDL_GetJoystickConnectionState(stick.joystick);
+}
 
-				sticks[joyid].button_events[my_event.jbutton.button] |= 0b101;
-				sticks[joyid].button_events[SDL_GAMEPAD_BUTTON_ANY] |= 0b101;
-				sticks[joyid].button_events[SDL_GAMEPAD_ANY] |= 0b101;
-			}
-			break;
+// 查询手柄的能力：类型、拥有的按钮与摇杆、传感器与触摸板
+void GamepadProbeCapabilities(GMGamepad& stick)
+{
+	GMDeviceInfo& info = stick.info;
+	info.type = SDL_GAMEPAD_TYPE_UNKNOWN;
+	info.button_mask = 0;
+	info.axis_mask = 0;
+	info.sensor_mask = 0;
+	info.touchpad_count = 0;
+	if (stick.gamepad != nullptr)
+	{
+		info.type = SDL_GetGamepadType(stick.gamepad);
+		for (int i = 0; i < SDL_GAMEPAD_BUTTON_COUNT; i++)
+		{
+			if (SDL_GamepadHasButton(stick.gamepad, (SDL_GamepadButton)i))
+				info.button_mask |= 1u << i;
+		}
 
-			case SDL_EVENT_JOYSTICK_BUTTON_UP:
-			{
-				int joyid = GetJoystickID(my_event.jbutton.which);
-				if (joyid < 0)
-					break;
+		for (int i = 0; i < SDL_GAMEPAD_AXIS_COUNT; i++)
+		{
+			if (SDL_GamepadHasAxis(stick.gamepad, (SDL_GamepadAxis)i))
+				info.axis_mask |= 1u << i;
+		}
 
-				auto buttonEvent = &sticks[joyid].button_events[my_event.jbutton.button];
-				*buttonEvent &= 0b011;  // 关闭按钮事件
-				*buttonEvent |= 0b010;  // 打开按钮放开事件
-			
-				buttonEvent = &sticks[joyid].button_events[SDL_GAMEPAD_BUTTON_ANY];
-				*buttonEvent &= 0b011;
-				*buttonEvent |= 0b010;
-
-				buttonEvent = &sticks[joyid].button_events[SDL_GAMEPAD_ANY];
-				*buttonEvent &= 0b011;
-				*buttonEvent |= 0b010;
-			}
-			break;
+		for (int i = SDL_SENSOR_ACCEL; i <= SDL_SENSOR_GYRO_R; i++)
+		{
+			if (SDL_GamepadHasSensor(stick.gamepad, (SDL_SensorType)i))
+				info.sensor_mask |= 1u << i;
+		}
 
-			case SDL_EVENT_JOYSTICK_AXIS_MOTION:
-			{
-				int joyid = GetJoystickID(my_event.jbutton.which);
-				if (joyid < 0)
-					break;
+		info.touchpad_count = SDL_GetNumGamepadTouchpads(stick.gamepad);
+	}
+}
 
-				GMReal value = (GMReal)my_event.jaxis.value / 32767;
-				if (fabs(value) < sticks[joyid].deadzone)
-					value = 0;
-				else
-					value = lerp(sticks[joyid].deadzone, 1, 0, 1, fabs(value)) * sign(value);
+// 槽位实际使用的内死区：自动死区优先于配置
+inline float AxisInnerDeadzone(const GMGamepad& stick, int slot)
+{
+	return stick.drift_deadzone[slot] > 0 ? stick.drift_deadzone[slot] : stick.axis_config[slot].inner_deadzone;
+}
 
-				auto buttonEvent = &sticks[joyid].button_events[JoystickAxisOffset + my_event.jaxis.axis];
+void GamepadCompileAxis(GMGamepad& stick, int slot)
+{
+	GMAxisConfig config = stick.axis_config[slot];
+	config.inner_deadzone = AxisInnerDeadzone(stick, slot);
+	stick.axis_kernels[slot].Compile(config);
+}
 
-				if (fabs(value) > 0 && (*buttonEvent & 0b100) == 0)  // 摇杆刚开始运动
-					*buttonEvent |= 0b101;  // 打开按钮按下事件，并打开摇杆状态
-				else if (value == 0 && (*buttonEvent & 0b100) != 0)  // 摇杆结束运动，回到原位
-				{
-					*buttonEvent &= 0b011;  // 关闭摇杆状态
-					*buttonEvent |= 0b010;  // 打开按钮放开事件
-				}
-			}
-			break;
+void GamepadCompileAxes(GMGamepad& stick)
+{
+	stick.axis_kernels.resize(AxisSlotCount);
+	for (int i = 0; i < AxisSlotCount; i++)
+		GamepadCompileAxis(stick, i);
+}
 
-			case SDL_EVENT_JOYSTICK_HAT_MOTION:
-			{
-				int joyid = GetJoystickID(my_event.jbutton.which);
-				if (joyid < 0)
-					break;
+// 所有摇杆使用相同的内死区
+// 只修改配置，调用者需要重新编译并读取当前值
+void GamepadSetDeadzone(GMGamepad& stick, double deadzone)
+{
+	stick.deadzone = SDL_clamp(deadzone, 0.0, 1.0);
+	for (GMAxisConfig& config : stick.axis_config)
+		config.inner_deadzone = (float)stick.deadzone;
+}
 
-				auto hatEventUp = &sticks[joyid].button_events[JoystickHatOffset + my_event.jhat.hat * 4];
-				auto hatEventDown = &sticks[joyid].button_events[JoystickHatOffset + my_event.jhat.hat * 4 + 1];
-				auto hatEventLeft = &sticks[joyid].button_events[JoystickHatOffset + my_event.jhat.hat * 4 + 2];
-				auto hatEventRight = &sticks[joyid].button_events[JoystickHatOffset + my_event.jhat.hat * 4 + 3];
-				auto anyButtonEvent = &sticks[joyid].button_events[SDL_GAMEPAD_BUTTON_ANY];
-				auto anyEvent = &sticks[joyid].button_events[SDL_GAMEPAD_ANY];
+// 处理后的值确定后调用：计入时间积分，并执行 One-Euro 平滑（未开启时与处理后的值相同）
+void GamepadOutputAxis(GMGamepad& stick, int slot, Uint64 timestamp)
+{
+	stick.integrators[slot].Set(stick.axis_values[slot], timestamp);
 
-				std::list<char*> noPressEvents = {
-					hatEventUp, hatEventDown, hatEventLeft, hatEventRight
-				};
+	const GMAxisConfig& config = stick.axis_config[slot];
+	if (config.filter_min_cutoff <= 0)
+	{
+		stick.filters[slot].seeded = false;
+		stick.axis_filtered[slot] = stick.axis_values[slot];
+		return;
+	}
 
-				auto hatEvents = GamepadGetHat(my_event.jhat.value, hatEventUp, hatEventDown, hatEventLeft, hatEventRight);
-				for (auto event : hatEvents)
-				{
-					if ((*event & 0b100) == 0)
-					{
-						*event |= 0b101;  // 打开按钮按下事件，并打开方向键状态
-						*anyButtonEvent |= 0b101;
-						*anyEvent |= 0b101;
-					}
+	stick.axis_filtered[slot] = stick.filters[slot].Filter(stick.axis_values[slot], timestamp, config);
+}
 
-					noPressEvents.remove(event);
-				}
+// 处理摇杆事件的值，返回经过单轴流水线处理的值
+float GamepadSetAxis(GMGamepad& stick, int slot, float raw, Uint64 timestamp)
+{
+	int stick2d = StickFromSlot(slot);
+	if (stick2d >= 0)
+		stick.sticks2d_dirty |= 1u << stick2d;
 
-				for (auto event : noPressEvents)
-				{
-					if ((*event & 0b100) != 0)
-					{
-						*event &= 0b011;  // 关闭按钮事件
-						*event |= 0b001;  // 打开按钮按下事件
-					}
-				}
+	GMCalibration& calibration = stick.calibration;
+	if (!calibration.enabled)
+	{
+		stick.axis_raw[slot] = raw;
+		stick.axis_values[slot] = stick.axis_kernels[slot].Process(raw);
+	}
+	else
+	{
+		GMAxisCalibration& axis = calibration.axes[slot];
+		float value;
+		if (!calibration.learning)
+			value = axis.Normalize(raw);
+		else if (stick2d < 0)
+			value = axis.Learn(raw);
+		else
+		{
+			int partner = StickSlot(stick2d) == slot ? slot + 1 : slot - 1;
+			value = axis.Learn(raw, calibration.axes[partner].NearCenter());
+		}
 
-				if (noPressEvents.size() == 4 && (*anyButtonEvent & 0b100) != 0)
-				{
-					*anyButtonEvent &= 0b011;
-					*anyButtonEvent |= 0b010;
+		if (stick2d < 0)
+		{
+			stick.axis_raw[slot] = value;
+			stick.axis_values[slot] = stick.axis_kernels[slot].Process(value);
+		}
+		else
+		{
+			// 二维摇杆按外框形状修正距离，同时更新另一个轴
+			int sx = StickSlot(stick2d);
+			float x = calibration.axes[sx].normalized;
+			float y = calibration.axes[sx + 1].normalized;
+			float magnitude = sqrtf(x * x + y * y);
+			if (magnitude > 0)
+			{
+				GMStickGate& gate = calibration.gates[stick2d];
+				if (calibration.learning)
+					gate.Learn(x, y, magnitude);
 
-					*anyEvent &= 0b011;
-					*anyEvent |= 0b010;
-				}
+				float corrected = SDL_min(magnitude / gate.Radius(x, y), 1.0f);
+				x *= corrected / magnitude;
+				y *= corrected / magnitude;
 			}
-			break;
+
+			stick.axis_raw[sx] = x;
+			stick.axis_raw[sx + 1] = y;
+			stick.axis_values[sx] = stick.axis_kernels[sx].Process(x);
+			stick.axis_values[sx + 1] = stick.axis_kernels[sx + 1].Process(y);
 		}
 	}
 
-	return change;
-}
\ No newline at end of file
+	// 漂移统计使用进入死区阶段的值，二维摇杆的另一个轴也必须在中心附近
+	bool idle = (stick.button_events[SDL_GAMEPAD_BUTTON_ANY] & 0b100) == 0;
+	if (stick2d >= 0)
+	{
+		int partner = StickSlot(stick2d) == slot ? slot + 1 : slot - 1;
+		idle &= fabsf(stick.axis_raw[partner]) < DriftRestWindow;
+	}
+	stick.drift[slot].Add(stick.axis_raw[slot], idle, timestamp);
+
+	// 非单轴模式的二维摇杆在帧末得到处理后的值，由 StickProcessBatch 平滑与积分；
+	// 校准时二维摇杆的另一个轴也会改变，一并处理
+	int first = slot, last = slot;
+	if (stick2d >= 0 && calibration.enabled)
+	{
+		first = StickSlot(stick2d);
+		last = first + 1;
+	}
+
+	for (int i = first; i <= last; i++)
+	{
+		stick.axis_timestamps[i] = timestamp;
+		if (stick2d < 0 || stick.sticks2d[stick2d].mode == STICK_MODE_AXIAL)
+			GamepadOutputAxis(stick, i, timestamp);
+	}
+
+	if (stick2d >= 0 && stick.sticks2d[stick2d].mode == STICK_MODE_AXIAL)
+	{
+		int sx = StickSlot(stick2d);
+		stick.look[stick2d].Set(stick.axis_values[sx], stick.axis_values[sx + 1], timestamp);
+	}
+
+	return stick.axis_values[slot];
+}
+
+// 在手柄接入或映射改变时读取摇杆的当前值，之后由事件更新
+void GamepadSeedAxes(GMGamepad& stick)
+{
+	constexpr int RawAxisCount = JoystickHatOffset - JoystickAxisOffset;
+	Uint64 now = SDL_GetTicksNS();
+	stick.axis_values.fill(0);
+	stick.axis_raw.fill(0);
+	stick.axis_filtered.fill(0);
+	stick.axis_timestamps.fill(now);
+	stick.filters = {};
+	stick.integrators = {};
+	for (int i = 0; i < SDL_min(stick.info.axis_count, RawAxisCount); i++)
+	{
+		float value = SDL_clamp(SDL_GetJoystickAxis(stick.joystick, i) / 32767.0f, -1.0f, 1.0f);
+		GamepadSetAxis(stick, i, value, now);
+	}
+
+	for (int i = 0; i < SDL_GAMEPAD_AXIS_COUNT; i++)
+	{
+		float value = 0;
+		if (stick.gamepad != nullptr)
+			value = SDL_GetGamepadAxis(stick.gamepad, (SDL_GamepadAxis)i) / 32767.0f;
+		else if (stick.soft.enabled)
+			value = stick.soft.axes[i];
+
+		GamepadSetAxis(stick, RawAxisCount + i, SDL_clamp(value, -1.0f, 1.0f), now);
+	}
+
+	stick.sticks2d_dirty = (1u << StickCount) - 1;
+}
+
+
+// 根据 bindings 生成查询表。同一输出有多个绑定时以第一个为准。
+GMBindingTable BuildBindingTable(SDL_GamepadBinding** bindings, int count)
+{
+	GMBindingTable table;
+	std::array<bool, GMBindingTable::Size> filled{};
+
+	for (int i = 0; i < count; i++)
+	{
+		const SDL_GamepadBinding* bind = bindings[i];
+
+		int output;
+		if (bind->output_type == SDL_GAMEPAD_BINDTYPE_BUTTON)
+			output = bind->output.button;
+		else if (bind->output_type == SDL_GAMEPAD_BINDTYPE_AXIS)
+			output = DefinedAxisOffset - DefinedButtonOffset + bind->output.axis.axis;
+		else
+			continue;
+
+		if (output < 0 || output >= GMBindingTable::Size || filled[output])
+			continue;
+
+		filled[output] = true;
+		switch (bind->input_type)
+		{
+		case SDL_GAMEPAD_BINDTYPE_BUTTON:
+		{
+			table.original[output] = (Sint16)bind->input.button;
+			table.any[output] = SDL_GAMEPAD_BUTTON_ANY;
+		}
+		break;
+		case SDL_GAMEPAD_BINDTYPE_AXIS:
+		{
+			table.original[output] = (Sint16)(JoystickAxisOffset + bind->input.axis.axis);
+			table.any[output] = SDL_GAMEPAD_AXIS_ANY;
+		}
+		break;
+		case SDL_GAMEPAD_BINDTYPE_HAT:
+		{
+			table.any[output] = SDL_GAMEPAD_BUTTON_ANY;
+
+			int directions = GamepadGetHat(bind->input.hat.hat_mask);
+			if (directions != 0)
+				table.original[output] = (Sint16)(JoystickHatOffset + bind->input.hat.hat * 4 + SDL_MostSignificantBitIndex32(directions & -directions));
+		}
+		break;
+		default:
+			break;
+		}
+	}
+
+	return table;
+}
+
+// 重新获取 bindings 并生成查询表。新的 bindings 与查询表完整生成后才替换旧的，
+// 所以查询不会看到更新到一半的数据。
+void GamepadRebuildBindings(GMGamepad& stick)
+{
+	int count = 0;
+	SDL_GamepadBinding** bindings = nullptr;
+	if (stick.gamepad != nullptr)
+	{
+		TraceScope scope("SDL_GetGamepadBindings");
+		bindings = SDL_GetGamepadBindings(stick.gamepad, &count);
+		if (bindings == nullptr)
+			count = 0;
+	}
+
+	GMBindingTable table = BuildBindingTable(bindings, count);
+	if (stick.gamepad == nullptr && stick.soft.enabled)
+		table = stick.soft.table;
+
+	SDL_GamepadBinding** old_bindings = stick.bindings;
+	stick.bindings = bindings;
+	stick.binding_count = count;
+	stick.binding_table = table;
+
+	if (old_bindings != nullptr)
+		SDL_free(old_bindings);
+}
+
+// 后台写入线程：文件先写入临时文件再重命名，写入中途退出不会损坏已有的文件。
+// 同一文件尚未写入的旧数据会被新数据替换，所以频繁的修改只会写入最新的一份。
+struct GMFileWrite
+{
+	std::string path;
+	std::vector<Uint8> data;
+};
+
+struct GMFileWriter
+{
+	SDL_Thread* thread = nullptr;
+	SDL_Mutex* mutex = nullptr;
+	SDL_Condition* condition = nullptr;
+	std::vector<GMFileWrite> pending;
+	bool writing = false;
+	bool stopping = false;  // 写完所有待写入的文件后退出线程
+};
+
+GMFileWriter file_writer;
+
+int SDLCALL FileWriterThread(void*)
+{
+	GMFileWrite job;
+	SDL_LockMutex(file_writer.mutex);
+	while (true)
+	{
+		while (file_writer.pending.empty() && !file_writer.stopping)
+			SDL_WaitCondition(file_writer.condition, file_writer.mutex);
+
+		if (file_writer.pending.empty())
+			break;
+
+		job = std::move(file_writer.pending.back());
+		file_writer.pending.pop_back();
+		file_writer.writing = true;
+		SDL_UnlockMutex(file_writer.mutex);
+
+		std::string temp_path = job.path + ".tmp";
+		if (SDL_SaveFile(temp_path.c_str(), job.data.data(), job.data.size()))
+			SDL_RenamePath(temp_path.c_str(), job.path.c_str());
+
+		SDL_LockMutex(file_writer.mutex);
+		file_writer.writing = false;
+		SDL_BroadcastCondition(file_writer.condition);
+	}
+
+	SDL_UnlockMutex(file_writer.mutex);
+	return 0;
+}
+
+bool FileWriterStart()
+{
+	if (file_writer.thread != nullptr)
+		return true;
+
+	if (file_writer.mutex == nullptr)
+		file_writer.mutex = SDL_CreateMutex();
+	if (file_writer.condition == nullptr)
+		file_writer.condition = SDL_CreateCondition();
+	if (file_writer.mutex == nullptr || file_writer.condition == nullptr)
+		return false;
+
+	file_writer.thread = SDL_CreateThread(FileWriterThread, "GMGamepad file writer", nullptr);
+	return file_writer.thread != nullptr;
+}
+
+// 将 data 交给后台线程写入 path，data 的内容会被交换走
+void FileWriterQueue(const std::string& path, std::vector<Uint8>& data)
+{
+	SDL_LockMutex(file_writer.mutex);
+	GMFileWrite* job = nullptr;
+	for (GMFileWrite& pending : file_writer.pending)
+	{
+		if (pending.path == path)
+			job = &pending;
+	}
+
+	if (job == nullptr)
+	{
+		file_writer.pending.emplace_back();
+		job = &file_writer.pending.back();
+		job->path = path;
+	}
+
+	job->data.swap(data);
+	SDL_BroadcastCondition(file_writer.condition);
+	SDL_UnlockMutex(file_writer.mutex);
+}
+
+// 写完所有待写入的文件后结束后台线程
+void FileWriterStop()
+{
+	if (file_writer.thread == nullptr)
+		return;
+
+	SDL_LockMutex(file_writer.mutex);
+	file_writer.stopping = true;
+	SDL_BroadcastCondition(file_writer.condition);
+	SDL_UnlockMutex(file_writer.mutex);
+
+	SDL_WaitThread(file_writer.thread, nullptr);
+	file_writer.thread = nullptr;
+	file_writer.stopping = false;
+}
+
+// 等待所有文件写入完成
+void FileWriterWait()
+{
+	if (file_writer.thread == nullptr)
+		return;
+
+	SDL_LockMutex(file_writer.mutex);
+	while (!file_writer.pending.empty() || file_writer.writing)
+		SDL_WaitCondition(file_writer.condition, file_writer.mutex);
+	SDL_UnlockMutex(file_writer.mutex);
+}
+
+// 只读映射整个文件，Windows 以外的平台读取至内存
+struct GMMappedFile
+{
+	const Uint8* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	void* buffer = nullptr;
+#endif
+
+	bool Open(const char* path)
+	{
+#ifdef _WIN32
+		wchar_t wide_path[MAX_PATH];
+		if (MultiByteToWideChar(CP_UTF8, 0, path, -1, wide_path, MAX_PATH) == 0)
+			return false;
+
+		file = CreateFileW(wide_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+			return false;
+
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+			return false;
+
+		data = (const Uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		size = (size_t)file_size.QuadPart;
+#else
+		buffer = SDL_LoadFile(path, &size);
+		data = (const Uint8*)buffer;
+#endif
+		return data != nullptr;
+	}
+
+	void Close()
+	{
+#ifdef _WIN32
+		if (data != nullptr)
+			UnmapViewOfFile(data);
+		if (mapping != nullptr)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+
+		file = INVALID_HANDLE_VALUE;
+		mapping = nullptr;
+#else
+		SDL_free(buffer);
+		buffer = nullptr;
+#endif
+		data = nullptr;
+		size = 0;
+	}
+};
+
+// 按 GUID 保存的数据文件（设备配置、能力缓存）共用的格式（小端）：
+//   文件头  char magic[4]; Uint32 version; Uint32 count;
+//   记录    SDL_GUID guid; Uint32 size; 随后 size 字节的内容
+// 读取时按 size 跳过记录中无法识别的字段，新版本只能在记录末尾追加字段。
+struct GMRecordReader
+{
+	const Uint8* data;
+	size_t size;
+	size_t offset = 0;
+	Uint32 version = 0;
+	Uint32 count = 0;
+
+	bool ReadHeader(const char (&magic)[4])
+	{
+		Uint32 header[3];
+		if (size < sizeof(header) || SDL_memcmp(data, magic, sizeof(magic)) != 0)
+			return false;
+
+		SDL_memcpy(header, data, sizeof(header));
+		version = header[1];
+		count = header[2];
+		offset = sizeof(header);
+		return true;
+	}
+
+	bool ReadRecord(SDL_GUID& guid, const Uint8*& record, Uint32& record_size)
+	{
+		if (size - offset < sizeof(SDL_GUID) + sizeof(record_size))
+			return false;
+
+		SDL_memcpy(&guid, data + offset, sizeof(SDL_GUID));
+		SDL_memcpy(&record_size, data + offset + sizeof(SDL_GUID), sizeof(record_size));
+		offset += sizeof(SDL_GUID) + sizeof(record_size);
+		if (size - offset < record_size)
+			return false;
+
+		record = data + offset;
+		offset += record_size;
+		return true;
+	}
+};
+
+void AppendBytes(std::vector<Uint8>& buffer, const void* data, size_t size)
+{
+	buffer.insert(buffer.end(), (const Uint8*)data, (const Uint8*)data + size);
+}
+
+void WriteRecordHeader(std::vector<Uint8>& buffer, const char (&magic)[4], Uint32 version, Uint32 count)
+{
+	buffer.clear();
+	AppendBytes(buffer, magic, sizeof(magic));
+	AppendBytes(buffer, &version, sizeof(version));
+	AppendBytes(buffer, &count, sizeof(count));
+}
+
+// 设备配置：按 GUID 保存死区与软件映射，手柄断开后再次接入时自动应用。
+// 配置文件在打开时以内存映射的方式读取，修改后由后台线程写入，不会阻塞 gamepad_update。
+// 记录内容：float deadzone; Uint16 mapping_length; char mapping[mapping_length];
+//           （版本 2）Uint16 axis_count; float axis_config[axis_count][7];
+//                     float axis_thresholds[axis_count][2];  按下与放开阈值
+//                     float axis_filters[axis_count][3];     One-Euro 平滑的最小截止频率、速度系数与速度的截止频率
+//                     Uint16 stick_count; float sticks[stick_count][4];  死区模式、视角加速的时间、最大倍率与边缘
+//                     Uint16 direction_count; float directions[direction_count][3];  方向量化的方向数、滞回与距离
+//                     float debounce;  去抖动窗口（微秒）
+// 之后新增的字段以新的数组追加在记录末尾，不改变已有数组的长度。
+constexpr char ProfileMagic[4] = { 'G', 'M', 'P', 'F' };
+constexpr Uint32 ProfileVersion = 2;
+constexpr int AxisConfigFields = 7;
+constexpr int AxisThresholdFields = 2;
+constexpr int AxisFilterFields = 3;
+constexpr int StickSettingFields = 4;
+constexpr int DirectionSettingFields = 3;
+
+struct GMProfile
+{
+	SDL_GUID guid{};
+	float deadzone = 0.05f;
+	std::string soft_mapping;
+	bool has_axes = false;
+	std::array<GMAxisConfig, AxisSlotCount> axes;
+
+	// 二维摇杆、方向量化与去抖动的设置，只使用其中的配置项
+	bool has_settings = false;
+	std::array<GMStick2D, StickCount> sticks2d;
+	std::array<GMLookAccel, StickCount> look;
+	std::array<GMDirection, DirectionSourceCount> directions;
+	Uint64 debounce = 0;
+};
+
+void AxisConfigToFloats(const GMAxisConfig& config, float* fields)
+{
+	fields[0] = config.inner_deadzone;
+	fields[1] = config.outer_deadzone;
+	fields[2] = config.anti_deadzone;
+	fields[3] = config.curve;
+	fields[4] = config.sensitivity;
+	fields[5] = config.invert ? 1.0f : 0.0f;
+	fields[6] = config.clamp;
+}
+
+void AxisConfigFromFloats(const float* fields, GMAxisConfig& config)
+{
+	config.inner_deadzone = fields[0];
+	config.outer_deadzone = fields[1];
+	config.anti_deadzone = fields[2];
+	config.curve = fields[3];
+	config.sensitivity = fields[4];
+	config.invert = fields[5] != 0;
+	config.clamp = fields[6];
+}
+
+struct GMProfileStore
+{
+	std::vector<GMProfile> profiles;
+	std::string path;  // 为空时配置只保存在内存中
+	std::vector<Uint8> buffer;
+	bool dirty = false;
+};
+
+GMProfileStore profile_store;
+
+// 读取记录中 offset 处的每摇杆数组 float values[axis_count][stride]，超出记录时返回 false。offset 移至数组之后
+template <typename Apply>
+bool ReadAxisBlock(const Uint8* record, Uint32 record_size, size_t& offset, int axis_count, int stride, Apply apply)
+{
+	size_t block_size = sizeof(float) * stride * axis_count;
+	if (axis_count == 0 || offset + block_size > record_size)
+		return false;
+
+	for (int j = 0; j < SDL_min(axis_count, AxisSlotCount); j++)
+	{
+		float fields[AxisConfigFields];
+		SDL_memcpy(fields, record + offset + sizeof(float) * stride * j, sizeof(float) * stride);
+		apply(j, fields);
+	}
+
+	offset += block_size;
+	return true;
+}
+
+// 读取摇杆、方向量化与去抖动的设置，超出记录时保持默认值
+void ProfileParseSettings(const Uint8* record, Uint32 record_size, size_t offset, GMProfile& profile)
+{
+	float fields[StickSettingFields];
+	Uint16 stick_count = 0;
+	if (offset + sizeof(Uint16) > record_size)
+		return;
+
+	SDL_memcpy(&stick_count, record + offset, sizeof(Uint16));
+	offset += sizeof(Uint16);
+	if (offset + sizeof(float) * StickSettingFields * stick_count + sizeof(Uint16) > record_size)
+		return;
+
+	for (int j = 0; j < stick_count; j++, offset += sizeof(fields))
+	{
+		if (j >= StickCount)
+			continue;
+
+		SDL_memcpy(fields, record + offset, sizeof(fields));
+		profile.sticks2d[j].mode = (Uint8)SDL_clamp((int)fields[0], 0, STICK_MODE_COUNT - 1);
+		profile.look[j].ramp_time = SDL_max(fields[1], 0.0f);
+		profile.look[j].max_multiplier = SDL_max(fields[2], 1.0f);
+		profile.look[j].edge = SDL_clamp(fields[3], 0.0f, 1.0f);
+	}
+
+	Uint16 direction_count = 0;
+	SDL_memcpy(&direction_count, record + offset, sizeof(Uint16));
+	offset += sizeof(Uint16);
+	if (offset + sizeof(float) * (DirectionSettingFields * direction_count + 1) > record_size)
+		return;
+
+	for (int j = 0; j < direction_count; j++, offset += sizeof(float) * DirectionSettingFields)
+	{
+		if (j >= DirectionSourceCount)
+			continue;
+
+		SDL_memcpy(fields, record + offset, sizeof(float) * DirectionSettingFields);
+		int ways = (int)fields[0];
+		profile.directions[j].ways = (Uint8)(ways == 4 || ways == 8 ? ways : 0);
+		profile.directions[j].hysteresis = SDL_max(fields[1], 0.0f);
+		profile.directions[j].threshold = SDL_clamp(fields[2], 0.01f, 1.0f);
+	}
+
+	float debounce;
+	SDL_memcpy(&debounce, record + offset, sizeof(float));
+	profile.debounce = (Uint64)(SDL_max(debounce, 0.0f) * 1000);
+	profile.has_settings = true;
+}
+
+// 从映射的文件中解析配置，格式不正确或由更新的版本写入时返回 false
+bool ProfileParse(const Uint8* data, size_t size, std::vector<GMProfile>& profiles)
+{
+	GMRecordReader reader{ data, size };
+	if (!reader.ReadHeader(ProfileMagic) || reader.version > ProfileVersion)
+		return false;
+
+	for (Uint32 i = 0; i < reader.count; i++)
+	{
+		GMProfile profile;
+		const Uint8* record;
+		Uint32 record_size;
+		if (!reader.ReadRecord(profile.guid, record, record_size))
+			return false;
+
+		Uint16 mapping_length = 0;
+		if (record_size >= sizeof(float) + sizeof(Uint16))
+		{
+			SDL_memcpy(&profile.deadzone, record, sizeof(float));
+			SDL_memcpy(&mapping_length, record + sizeof(float), sizeof(Uint16));
+		}
+
+		size_t mapping_offset = sizeof(float) + sizeof(Uint16);
+		if (mapping_length > 0 && mapping_offset + mapping_length <= record_size)
+			profile.soft_mapping.assign((const char*)record + mapping_offset, mapping_length);
+
+		size_t axes_offset = mapping_offset + mapping_length;
+		Uint16 axis_count = 0;
+		if (axes_offset + sizeof(Uint16) <= record_size)
+			SDL_memcpy(&axis_count, record + axes_offset, sizeof(Uint16));
+
+		axes_offset += sizeof(Uint16);
+		profile.has_axes = reader.version >= 2 && ReadAxisBlock(record, record_size, axes_offset, axis_count, AxisConfigFields,
+			[&](int j, const float* fields) { AxisConfigFromFloats(fields, profile.axes[j]); });
+
+		if (profile.has_axes)
+		{
+			ReadAxisBlock(record, record_size, axes_offset, axis_count, AxisThresholdFields, [&](int j, const float* fields)
+			{
+				profile.axes[j].press_threshold = fields[0];
+				profile.axes[j].release_threshold = fields[1];
+			});
+		}
+
+		if (profile.has_axes)
+		{
+			ReadAxisBlock(record, record_size, axes_offset, axis_count, AxisFilterFields, [&](int j, const float* fields)
+			{
+				profile.axes[j].filter_min_cutoff = fields[0];
+				profile.axes[j].filter_beta = fields[1];
+				profile.axes[j].filter_d_cutoff = fields[2];
+			});
+		}
+
+		if (profile.has_axes)
+			ProfileParseSettings(record, record_size, axes_offset, profile);
+
+		profile.deadzone = SDL_clamp(profile.deadzone, 0.0f, 1.0f);
+		profiles.push_back(std::move(profile));
+	}
+
+	return true;
+}
+
+void ProfileSerialize(const std::vector<GMProfile>& profiles, std::vector<Uint8>& buffer)
+{
+	WriteRecordHeader(buffer, ProfileMagic, ProfileVersion, (Uint32)profiles.size());
+	for (const GMProfile& profile : profiles)
+	{
+		Uint16 mapping_length = (Uint16)SDL_min(profile.soft_mapping.size(), (size_t)SDL_MAX_UINT16);
+		Uint16 axis_count = profile.has_axes ? AxisSlotCount : 0;
+		Uint32 record_size = sizeof(float) + sizeof(Uint16) * 2 + mapping_length + sizeof(float) * (AxisConfigFields + AxisThresholdFields + AxisFilterFields) * axis_count;
+		if (axis_count > 0)
+			record_size += sizeof(Uint16) * 2 + sizeof(float) * (StickSettingFields * StickCount + DirectionSettingFields * DirectionSourceCount + 1);
+		AppendBytes(buffer, &profile.guid, sizeof(SDL_GUID));
+		AppendBytes(buffer, &record_size, sizeof(record_size));
+		AppendBytes(buffer, &profile.deadzone, sizeof(float));
+		AppendBytes(buffer, &mapping_length, sizeof(mapping_length));
+		AppendBytes(buffer, profile.soft_mapping.data(), mapping_length);
+		AppendBytes(buffer, &axis_count, sizeof(axis_count));
+		for (int j = 0; j < axis_count; j++)
+		{
+			float fields[AxisConfigFields];
+			AxisConfigToFloats(profile.axes[j], fields);
+			AppendBytes(buffer, fields, sizeof(fields));
+		}
+
+		// 新增的字段作为单独的数组追加在末尾，旧版本按 size 跳过
+		for (int j = 0; j < axis_count; j++)
+		{
+			float thresholds[AxisThresholdFields] = { profile.axes[j].press_threshold, profile.axes[j].release_threshold };
+			AppendBytes(buffer, thresholds, sizeof(thresholds));
+		}
+
+		for (int j = 0; j < axis_count; j++)
+		{
+			const GMAxisConfig& config = profile.axes[j];
+			float filter[AxisFilterFields] = { config.filter_min_cutoff, config.filter_beta, config.filter_d_cutoff };
+			AppendBytes(buffer, filter, sizeof(filter));
+		}
+
+		if (axis_count == 0)
+			continue;
+
+		Uint16 stick_count = StickCount;
+		AppendBytes(buffer, &stick_count, sizeof(stick_count));
+		for (int j = 0; j < StickCount; j++)
+		{
+			const GMLookAccel& look = profile.look[j];
+			float fields[StickSettingFields] = { (float)profile.sticks2d[j].mode, look.ramp_time, look.max_multiplier, look.edge };
+			AppendBytes(buffer, fields, sizeof(fields));
+		}
+
+		Uint16 direction_count = DirectionSourceCount;
+		AppendBytes(buffer, &direction_count, sizeof(direction_count));
+		for (const GMDirection& direction : profile.directions)
+		{
+			float fields[DirectionSettingFields] = { (float)direction.ways, direction.hysteresis, direction.threshold };
+			AppendBytes(buffer, fields, sizeof(fields));
+		}
+
+		float debounce = profile.debounce / 1000.0f;
+		AppendBytes(buffer, &debounce, sizeof(debounce));
+	}
+}
+
+GMProfile* ProfileFind(const SDL_GUID& guid)
+{
+	for (GMProfile& profile : profile_store.profiles)
+	{
+		if (SDL_memcmp(&profile.guid, &guid, sizeof(SDL_GUID)) == 0)
+			return &profile;
+	}
+
+	return nullptr;
+}
+
+// 将手柄当前的设置保存至配置
+void ProfileStore(const GMGamepad& stick)
+{
+	GMProfile* profile = ProfileFind(stick.info.guid);
+	if (profile == nullptr)
+	{
+		profile_store.profiles.emplace_back();
+		profile = &profile_store.profiles.back();
+		profile->guid = stick.info.guid;
+	}
+
+	profile->deadzone = (float)stick.deadzone;
+	profile->soft_mapping = stick.soft.enabled ? stick.soft.source : std::string();
+	profile->has_axes = true;
+	profile->axes = stick.axis_config;
+	profile->has_settings = true;
+	profile->sticks2d = stick.sticks2d;
+	profile->look = stick.look;
+	profile->directions = stick.directions;
+	profile->debounce = stick.debounce.window;
+	profile_store.dirty = true;
+}
+
+// 摇杆配置改变后重新编译、读取当前值并保存至设备配置
+void GamepadAxisConfigChanged(GMGamepad& stick)
+{
+	GamepadCompileAxes(stick);
+	GamepadSeedAxes(stick);
+	ProfileStore(stick);
+}
+
+int CompileSoftMapping(const char* mapping, GMSoftMapping& soft);
+
+// 手柄接入时应用配置
+void ProfileApply(GMGamepad& stick)
+{
+	const GMProfile* profile = ProfileFind(stick.info.guid);
+	if (profile == nullptr)
+		return;
+
+	GamepadSetDeadzone(stick, profile->deadzone);
+	if (profile->has_axes)
+		stick.axis_config = profile->axes;
+
+	GamepadCompileAxes(stick);
+
+	if (profile->has_settings)
+	{
+		for (int j = 0; j < StickCount; j++)
+		{
+			stick.sticks2d[j].mode = profile->sticks2d[j].mode;
+			stick.sticks2d_dirty |= 1u << j;
+			stick.look[j].ramp_time = profile->look[j].ramp_time;
+			stick.look[j].max_multiplier = profile->look[j].max_multiplier;
+			stick.look[j].edge = profile->look[j].edge;
+		}
+
+		for (int j = 0; j < DirectionSourceCount; j++)
+		{
+			stick.directions[j].ways = profile->directions[j].ways;
+			stick.directions[j].hysteresis = profile->directions[j].hysteresis;
+			stick.directions[j].threshold = profile->directions[j].threshold;
+			stick.directions[j].sector = -1;
+		}
+
+		stick.debounce.window = profile->debounce;
+	}
+
+	if (stick.gamepad == nullptr && !profile->soft_mapping.empty()
+		&& CompileSoftMapping(profile->soft_mapping.c_str(), stick.soft) > 0)
+	{
+		stick.soft.source = profile->soft_mapping;
+		GamepadRebuildBindings(stick);
+	}
+
+	GamepadSeedAxes(stick);
+}
+
+// 能力缓存：按 GUID 与固件版本保存受支持手柄的查询表与能力。
+// 再次接入时直接使用缓存，SDL_GetGamepadBindings 与能力查询推迟到之后的帧中验证。
+// 记录内容：Uint16 firmware; Uint16 table_size; Sint32 type; Uint32 button_mask; Uint32 axis_mask;
+//           Uint32 sensor_mask; Sint32 touchpad_count; Sint16 original[table_size]; Sint16 any[table_size];
+//           （版本 2）名称、映射与类型名称，每个为 Uint16 length; char text[length]; 从版本 1 读取的记录没有这部分
+constexpr char CapabilityMagic[4] = { 'G', 'M', 'C', 'C' };
+constexpr Uint32 CapabilityVersion = 2;
+
+struct GMCapability
+{
+	SDL_GUID guid{};
+	Uint16 firmware = 0;
+	Sint32 type = SDL_GAMEPAD_TYPE_UNKNOWN;
+	Uint32 button_mask = 0;
+	Uint32 axis_mask = 0;
+	Uint32 sensor_mask = 0;
+	Sint32 touchpad_count = 0;
+	GMBindingTable table;
+
+	// 版本 1 的缓存没有字符串，命中时仍需从 SDL 获取
+	bool has_strings = false;
+	std::string name;
+	std::string mapping;
+	std::string type_name;
+};
+
+struct GMCapabilityCache
+{
+	std::vector<GMCapability> entries;
+	std::string path;  // 为空时缓存只保存在内存中
+	std::vector<Uint8> buffer;
+	bool dirty = false;
+};
+
+GMCapabilityCache capability_cache;
+
+// 读取 Uint16 长度前缀的字符串，超出记录时返回 false
+bool ReadRecordString(const Uint8* record, Uint32 record_size, size_t& offset, std::string& text)
+{
+	Uint16 length;
+	if (offset + sizeof(Uint16) > record_size)
+		return false;
+
+	SDL_memcpy(&length, record + offset, sizeof(Uint16));
+	offset += sizeof(Uint16);
+	if (offset + length > record_size)
+		return false;
+
+	text.assign((const char*)record + offset, length);
+	offset += length;
+	return true;
+}
+
+void AppendRecordString(std::vector<Uint8>& buffer, const std::string& text)
+{
+	Uint16 length = (Uint16)SDL_min(text.size(), (size_t)SDL_MAX_UINT16);
+	AppendBytes(buffer, &length, sizeof(length));
+	AppendBytes(buffer, text.data(), length);
+}
+
+bool CapabilityParse(const Uint8* data, size_t size, std::vector<GMCapability>& entries)
+{
+	GMRecordReader reader{ data, size };
+	if (!reader.ReadHeader(CapabilityMagic) || reader.version > CapabilityVersion)
+		return false;
+
+	constexpr size_t FieldsSize = sizeof(Uint16) * 2 + sizeof(Sint32) * 2 + sizeof(Uint32) * 3;
+	constexpr size_t TableSize = sizeof(Sint16) * GMBindingTable::Size;
+	for (Uint32 i = 0; i < reader.count; i++)
+	{
+		GMCapability entry;
+		const Uint8* record;
+		Uint32 record_size;
+		if (!reader.ReadRecord(entry.guid, record, record_size))
+			return false;
+
+		if (record_size < FieldsSize + TableSize * 2)
+			continue;
+
+		Uint16 table_size;
+		SDL_memcpy(&entry.firmware, record, sizeof(Uint16));
+		SDL_memcpy(&table_size, record + 2, sizeof(Uint16));
+		SDL_memcpy(&entry.type, record + 4, sizeof(Sint32));
+		SDL_memcpy(&entry.button_mask, record + 8, sizeof(Uint32));
+		SDL_memcpy(&entry.axis_mask, record + 12, sizeof(Uint32));
+		SDL_memcpy(&entry.sensor_mask, record + 16, sizeof(Uint32));
+		SDL_memcpy(&entry.touchpad_count, record + 20, sizeof(Sint32));
+		if (table_size != GMBindingTable::Size)  // 由不同版本的扩展生成，查询表无法使用
+			continue;
+
+		SDL_memcpy(entry.table.original.data(), record + FieldsSize, TableSize);
+		SDL_memcpy(entry.table.any.data(), record + FieldsSize + TableSize, TableSize);
+
+		size_t offset = FieldsSize + TableSize * 2;
+		entry.has_strings = reader.version >= 2
+			&& ReadRecordString(record, record_size, offset, entry.name)
+			&& ReadRecordString(record, record_size, offset, entry.mapping)
+			&& ReadRecordString(record, record_size, offset, entry.type_name);
+		entries.push_back(entry);
+	}
+
+	return true;
+}
+
+void CapabilitySerialize(const std::vector<GMCapability>& entries, std::vector<Uint8>& buffer)
+{
+	WriteRecordHeader(buffer, CapabilityMagic, CapabilityVersion, (Uint32)entries.size());
+	for (const GMCapability& entry : entries)
+	{
+		Uint16 table_size = GMBindingTable::Size;
+		Uint32 record_size = sizeof(Uint16) * 2 + sizeof(Sint32) * 2 + sizeof(Uint32) * 3 + sizeof(Sint16) * table_size * 2;
+		if (entry.has_strings)
+		{
+			for (const std::string* text : { &entry.name, &entry.mapping, &entry.type_name })
+				record_size += sizeof(Uint16) + (Uint32)SDL_min(text->size(), (size_t)SDL_MAX_UINT16);
+		}
+		AppendBytes(buffer, &entry.guid, sizeof(SDL_GUID));
+		AppendBytes(buffer, &record_size, sizeof(record_size));
+		AppendBytes(buffer, &entry.firmware, sizeof(Uint16));
+		AppendBytes(buffer, &table_size, sizeof(Uint16));
+		AppendBytes(buffer, &entry.type, sizeof(Sint32));
+		AppendBytes(buffer, &entry.button_mask, sizeof(Uint32));
+		AppendBytes(buffer, &entry.axis_mask, sizeof(Uint32));
+		AppendBytes(buffer, &entry.sensor_mask, sizeof(Uint32));
+		AppendBytes(buffer, &entry.touchpad_count, sizeof(Sint32));
+		AppendBytes(buffer, entry.table.original.data(), sizeof(Sint16) * table_size);
+		AppendBytes(buffer, entry.table.any.data(), sizeof(Sint16) * table_size);
+		if (entry.has_strings)
+		{
+			AppendRecordString(buffer, entry.name);
+			AppendRecordString(buffer, entry.mapping);
+			AppendRecordString(buffer, entry.type_name);
+		}
+	}
+}
+
+GMCapability* CapabilityFind(const SDL_GUID& guid, Uint16 firmware)
+{
+	for (GMCapability& entry : capability_cache.entries)
+	{
+		if (entry.firmware == firmware && SDL_memcmp(&entry.guid, &guid, sizeof(SDL_GUID)) == 0)
+			return &entry;
+	}
+
+	return nullptr;
+}
+
+// 将受支持手柄当前的查询表、能力与字符串保存至缓存，需要先调用 GamepadCacheStrings
+void CapabilityStore(const GMGamepad& stick)
+{
+	if (stick.gamepad == nullptr)
+		return;
+
+	const GMDeviceInfo& info = stick.info;
+	GMCapability* entry = CapabilityFind(info.guid, info.firmware);
+	if (entry == nullptr)
+	{
+		capability_cache.entries.emplace_back();
+		entry = &capability_cache.entries.back();
+		entry->guid = info.guid;
+		entry->firmware = info.firmware;
+	}
+	else if (entry->type == info.type && entry->button_mask == info.button_mask && entry->axis_mask == info.axis_mask
+		&& entry->sensor_mask == info.sensor_mask && entry->touchpad_count == info.touchpad_count
+		&& entry->table.original == stick.binding_table.original && entry->table.any == stick.binding_table.any
+		&& entry->has_strings && entry->name == stick.strings.name && entry->mapping == stick.strings.mapping
+		&& entry->type_name == stick.strings.type_name)
+		return;
+
+	entry->type = info.type;
+	entry->button_mask = info.button_mask;
+	entry->axis_mask = info.axis_mask;
+	entry->sensor_mask = info.sensor_mask;
+	entry->touchpad_count = info.touchpad_count;
+	entry->table = stick.binding_table;
+	entry->has_strings = true;
+	entry->name = stick.strings.name;
+	entry->mapping = stick.strings.mapping;
+	entry->type_name = stick.strings.type_name;
+	capability_cache.dirty = true;
+}
+
+// 缓存命中时使用缓存的查询表、能力与字符串，返回是否命中。没有字符串的旧缓存视为未命中
+bool CapabilityApply(GMGamepad& stick)
+{
+	const GMCapability* entry = CapabilityFind(stick.info.guid, stick.info.firmware);
+	if (stick.gamepad == nullptr || entry == nullptr || !entry->has_strings)
+		return false;
+
+	GMDeviceInfo& info = stick.info;
+	info.type = entry->type;
+	info.button_mask = entry->button_mask;
+	info.axis_mask = entry->axis_mask;
+	info.sensor_mask = entry->sensor_mask;
+	info.touchpad_count = entry->touchpad_count;
+	stick.binding_table = entry->table;
+
+	GMDeviceStrings& strings = stick.strings;
+	strings.name = entry->name;
+	strings.mapping = entry->mapping;
+	strings.type_name = entry->type_name;
+	GamepadCacheInstanceStrings(stick);
+	return true;
+}
+
+// 在帧末将修改过的配置与缓存交给后台线程写入，同一帧内的多次修改只写入一次。返回是否有写入
+bool FileStoreQueueSave()
+{
+	if (file_writer.thread == nullptr)
+		return false;
+
+	bool queued = false;
+	if (profile_store.dirty && !profile_store.path.empty())
+	{
+		queued = true;
+		profile_store.dirty = false;
+		ProfileSerialize(profile_store.profiles, profile_store.buffer);
+		FileWriterQueue(profile_store.path, profile_store.buffer);
+	}
+
+	if (capability_cache.dirty && !capability_cache.path.empty())
+	{
+		queued = true;
+		capability_cache.dirty = false;
+		CapabilitySerialize(capability_cache.entries, capability_cache.buffer);
+		FileWriterQueue(capability_cache.path, capability_cache.buffer);
+	}
+
+	return queued;
+}
+
+// 在手柄映射改变时调用，重新生成所有由映射派生的数据
+void GamepadRefresh(GMGamepad& stick)
+{
+	GamepadRebuildBindings(stick);
+	GamepadCacheInfo(stick);
+	GamepadProbeCapabilities(stick);
+	GamepadCacheStrings(stick);
+	CapabilityStore(stick);
+	GamepadSeedAxes(stick);
+	stick.validation_pending = false;
+}
+
+// 在手柄接入时调用，能力缓存命中时跳过 SDL_GetGamepadBindings、能力查询与 SDL_GetGamepadMapping
+void GamepadConnect(GMGamepad& stick)
+{
+	GamepadCacheInfo(stick);
+	if (CapabilityApply(stick))
+		stick.validation_pending = true;
+	else
+	{
+		GamepadRebuildBindings(stick);
+		GamepadProbeCapabilities(stick);
+		GamepadCacheStrings(stick);
+		CapabilityStore(stick);
+	}
+
+	GamepadCompileAxes(stick);
+	GamepadSeedAxes(stick);
+}
+
+// 验证使用能力缓存接入的手柄，每帧最多验证一个，缓存过期时更新手柄与缓存。返回是否验证了手柄
+bool GamepadValidateCapabilities()
+{
+	for (GMGamepad& stick : sticks)
+	{
+		if (!stick.validation_pending)
+			continue;
+
+		// 映射字符串可能在查询表不变时改变（名称或未使用的绑定），所以字符串也总是重新获取。
+		// CapabilityStore 只在缓存与设备不同时标记写入
+		TraceScope scope("capability validation");
+		GamepadRebuildBindings(stick);
+		GamepadProbeCapabilities(stick);
+		GamepadCacheStrings(stick);
+		CapabilityStore(stick);
+		stick.validation_pending = false;
+		return true;
+	}
+
+	return false;
+}
+
+expReal gamepad_init(GMString gamepadDB)
+{
+	InstallMemoryFunctions();
+	enumerate_pending = true;
+
+	// gamepad_quit 之后再次初始化时恢复已加载的配置文件的写入
+	if (!profile_store.path.empty() || !capability_cache.path.empty())
+		FileWriterStart();
+
+	if (*gamepadDB != '\0')
+		SDL_AddGamepadMappingsFromFile(gamepadDB);
+
+	bool result = SDL_Init(SDL_INIT_GAMEPAD);
+	SDL_SetGamepadEventsEnabled(true);
+	return result;
+}
+
+expReal gamepad_is_supported(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].gamepad != nullptr;
+}
+
+expReal gamepad_get_device_count() { return sticks.size(); }
+
+expString gamepad_get_description(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return "no gamepad";
+
+	return sticks[index].strings.name.c_str();
+}
+
+expReal gamepad_get_type(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return -1;
+
+	return sticks[index].info.type;
+}
+
+expString gamepad_get_guid(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return "device index out of range";
+
+	return sticks[index].strings.guid.c_str();
+}
+
+expString gamepad_get_serial(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return "device index out of range";
+
+	return sticks[index].strings.serial.c_str();
+}
+
+expString gamepad_get_path(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return "device index out of range";
+
+	return sticks[index].strings.path.c_str();
+}
+
+expString gamepad_get_type_name(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return "device index out of range";
+
+	return sticks[index].strings.type_name.c_str();
+}
+
+expReal gamepad_get_id(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return -1;
+
+	return sticks[index].info.instance_id;
+}
+
+expReal gamepad_get_axis_deadzone(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	// 自动死区生效时返回各轴实际内死区的最大值
+	const GMGamepad& stick = sticks[index];
+	double deadzone = stick.deadzone;
+	bool drift = false;
+	for (int slot = 0; slot < AxisSlotCount; slot++)
+		drift |= stick.drift_deadzone[slot] > 0;
+
+	if (drift)
+	{
+		deadzone = 0;
+		for (int slot = 0; slot < AxisSlotCount; slot++)
+			deadzone = SDL_max(deadzone, AxisInnerDeadzone(stick, slot));
+	}
+
+	return deadzone;
+}
+
+expReal gamepad_set_axis_deadzone(GMReal id, GMReal deadzone)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	// 摇杆不动时不会产生事件，需要立即用新的死区重新计算缓存的值
+	GamepadSetDeadzone(sticks[index], deadzone);
+	GamepadAxisConfigChanged(sticks[index]);
+	return 1;
+}
+
+expReal gamepad_axis_value(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int slot = AxisSlot((int)axis);
+	if (index >= sticks.size() || slot < 0)
+		return 0;
+
+	return sticks[index].axis_values[slot];
+}
+
+expReal gamepad_button_check_direct(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size() || button < 0)
+		return 0;
+
+	int input = (int)button;
+
+	if (input < DefinedButtonOffset)
+	{
+		if (input < JoystickAxisOffset)
+			return SDL_GetJoystickButton(sticks[index].joystick, input);
+		else if (input < JoystickHatOffset)
+		{
+			GMReal value = gamepad_axis_value(id, input);
+			return fabs(sign(value));
+		}
+		else
+		{
+			int mask = SDL_GetJoystickHat(sticks[index].joystick, (input - JoystickHatOffset) / 4);
+			if ((GamepadGetHat(mask) & (1 << ((input - JoystickHatOffset) % 4))) != 0)
+				return 1;  // 按下
+		}
+		return SDL_GetJoystickButton(sticks[index].joystick, input);
+	}
+	else if (input < DefinedAxisOffset)
+	{
+		if (sticks[index].gamepad == nullptr)
+			return (sticks[index].button_events[input] & 0b100) != 0;  // 软件映射的手柄
+
+		return SDL_GetGamepadButton(sticks[index].gamepad, (SDL_GamepadButton)
+			(input - DefinedButtonOffset));
+	}
+	else if (input < DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+	{
+		GMReal value = gamepad_axis_value(id, input);
+		return fabs(sign(value));
+	}
+	else if (input >= DirectionOffset && input < ButtonCount)
+		return (sticks[index].button_events[input] & 0b100) != 0;  // 在帧末量化，没有更直接的来源
+
+	return 0;
+}
+
+expReal gamepad_button_check(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button;
+	if (index >= sticks.size() || input >= ButtonCount)
+		return 0;
+
+	return (sticks[index].button_events[input] & 0b100) != 0;
+}
+
+expReal gamepad_button_check_pressed(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button;
+	if (index >= sticks.size() || input >= ButtonCount)
+		return 0;
+
+	return (sticks[index].button_events[input] & 0b001) != 0;
+}
+
+expReal gamepad_button_check_released(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button;
+	if (index >= sticks.size() || input >= ButtonCount)
+		return 0;
+
+	return (sticks[index].button_events[input] & 0b010) != 0;
+}
+
+// 将输入名称解析为输入值，可在初始化时调用一次并保存结果，名称无效时返回 -1
+expReal gamepad_input_code(GMString name)
+{
+	return InputCodeFromName(name);
+}
+
+// 返回输入值对应的名称
+expString gamepad_input_name(GMReal input)
+{
+	int code = (int)input;
+	for (const InputNameEntry& entry : InputNames)
+	{
+		if (entry.code == code)
+			return entry.text;
+	}
+
+	return "";
+}
+
+expReal gamepad_button_check_name(GMReal id, GMString name)
+{
+	int input = InputCodeFromName(name);
+	if (input < 0)
+		return 0;
+
+	return gamepad_button_check(id, input);
+}
+
+expReal gamepad_button_check_pressed_name(GMReal id, GMString name)
+{
+	int input = InputCodeFromName(name);
+	if (input < 0)
+		return 0;
+
+	return gamepad_button_check_pressed(id, input);
+}
+
+expReal gamepad_button_check_released_name(GMReal id, GMString name)
+{
+	int input = InputCodeFromName(name);
+	if (input < 0)
+		return 0;
+
+	return gamepad_button_check_released(id, input);
+}
+
+expReal gamepad_axis_value_name(GMReal id, GMString name)
+{
+	int input = InputCodeFromName(name);
+	if (input < 0)
+		return 0;
+
+	return gamepad_axis_value(id, input);
+}
+
+// 上一帧中处理后的值对时间的平均值，包含两次 gamepad_update 之间的所有变化
+expReal gamepad_axis_value_average(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int slot = AxisSlot((int)axis);
+	if (index >= sticks.size() || slot < 0)
+		return 0;
+
+	return sticks[index].integrators[slot].average;
+}
+
+// 经过 One-Euro 平滑的值，未开启平滑时与 gamepad_axis_value 相同
+expReal gamepad_axis_value_filtered(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int slot = AxisSlot((int)axis);
+	if (index >= sticks.size() || slot < 0)
+		return 0;
+
+	return sticks[index].axis_filtered[slot];
+}
+
+int GamepadGetOriginalIndex(uint id, int button, int* any = nullptr)
+{
+	if (any != nullptr)
+		*any = SDL_GAMEPAD_BUTTON_INVALID;
+
+	if (button < DefinedButtonOffset || button >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+		return -1;
+
+	StatAdd(GM_STAT_MAPPING_LOOKUPS);
+
+	const GMBindingTable& table = sticks[id].binding_table;
+	if (any != nullptr)
+		*any = table.any[button - DefinedButtonOffset];
+
+	return table.original[button - DefinedButtonOffset];
+}
+
+expReal gamepad_button_press(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button;
+	if (index >= sticks.size())
+		return 0;
+
+	if (input < 0 || input >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+		return 0;
+
+	sticks[index].button_events[input] |= 0b101;
+	sticks[index].button_events[SDL_GAMEPAD_ANY] |= 0b101;
+
+	// 如果是受支持的手柄且传入游戏手柄按钮常量，则原始索引也会打开事件
+	int any_index;
+	int result = GamepadGetOriginalIndex(index, input, &any_index);
+	if (result >= 0)
+		sticks[index].button_events[result] |= 0b101;
+
+	if (any_index != SDL_GAMEPAD_BUTTON_INVALID)
+		sticks[index].button_events[any_index] |= 0b101;
+
+	GamepadSyncMasks(sticks[index]);
+	return 1;
+}
+
+expReal gamepad_button_release(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button;
+	if (index >= sticks.size())
+		return 0;
+
+	if (input < 0 || input >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+		return 0;
+
+	auto event = &sticks[index].button_events[input];
+	*event &= 0b011;  // 关闭按钮事件
+	*event |= 0b010;  // 打开按钮放开事件
+
+	event = &sticks[index].button_events[SDL_GAMEPAD_ANY];
+	*event &= 0b011;
+	*event |= 0b010;
+
+	// 如果是受支持的手柄且传入游戏手柄按钮常量，则原始索引也会打开事件
+	int any_index;
+	int result = GamepadGetOriginalIndex(index, input, &any_index);
+	if (result >= 0)
+	{
+		event = &sticks[index].button_events[result];
+		*event &= 0b011;
+		*event |= 0b010;
+	}
+
+	if (any_index != SDL_GAMEPAD_BUTTON_INVALID)
+	{
+		event = &sticks[index].button_events[any_index];
+		*event &= 0b011;
+		*event |= 0b010;
+	}
+
+	GamepadSyncMasks(sticks[index]);
+	return 1;
+}
+
+expReal gamepad_set_vibration(GMReal id, GMReal low, GMReal high, GMReal len)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	Uint16 low_strength = (Uint16)(SDL_clamp(low * 65535, 0, 65535));
+	Uint16 high_strength = (Uint16)(SDL_clamp(high * 65535, 0, 65535));
+	Uint32 len_ms = (Uint32)(std::max(0.0, len * 1000));
+
+	return SDL_RumbleJoystick(sticks[(uint)id].joystick, low_strength, high_strength, len_ms);
+}
+
+expReal gamepad_set_color(GMReal id, GMReal col)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	int color = (int)col;
+	Uint8 b = (Uint8)((color >> 16) & 0xFF);
+	Uint8 g = (Uint8)((color >> 8) & 0xFF);
+	Uint8 r = (Uint8)(color & 0xFF);
+
+	return SDL_SetJoystickLED(sticks[(uint)id].joystick, r, g, b);
+}
+
+expReal gamepad_axis_count(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	return sticks[(uint)id].info.axis_count;
+}
+
+expReal gamepad_button_count(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	return sticks[(uint)id].info.button_count;
+}
+
+expReal gamepad_hat_count(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	return sticks[(uint)id].info.hat_count;
+}
+
+expReal gamepad_get_vendor(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	return sticks[(uint)id].info.vendor;
+}
+
+expReal gamepad_get_product(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	return sticks[(uint)id].info.product;
+}
+
+expReal gamepad_get_version(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	return sticks[(uint)id].info.version;
+}
+
+// 传入手柄按钮常量（100 - 125），判断手柄是否拥有该按钮
+expReal gamepad_has_button(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button - DefinedButtonOffset;
+	if (index >= sticks.size() || input < 0 || input >= SDL_GAMEPAD_BUTTON_COUNT)
+		return 0;
+
+	return (sticks[index].info.button_mask & (1u << input)) != 0;
+}
+
+// 传入手柄摇杆常量（126 - 131），判断手柄是否拥有该摇杆
+expReal gamepad_has_axis(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int input = (int)axis - DefinedAxisOffset;
+	if (index >= sticks.size() || input < 0 || input >= SDL_GAMEPAD_AXIS_COUNT)
+		return 0;
+
+	return (sticks[index].info.axis_mask & (1u << input)) != 0;
+}
+
+// 一次返回设备的全部固定信息，以逗号分隔：
+// 摇杆数,按钮数,方向键数,类型,厂商ID,产品ID,产品版本,连接方式,按钮掩码,摇杆掩码,GUID,实例ID
+// GUID 与 gamepad_get_guid 相同（没有时为 none），实例ID 为 SDL_JoystickID
+expString gamepad_get_info(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return "device index out of range";
+
+	return sticks[index].strings.info.c_str();
+}
+
+expReal gamepad_get_inputs_index(GMReal id, GMReal button)
+{
+	uint index = (uint)id;
+	int input = (int)button;
+	if (index >= sticks.size() || input >= ButtonCount)
+		return -1;
+
+	return GamepadGetOriginalIndex(index, input);
+}
+
+expString gamepad_get_mapping(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return "device index out of range";
+
+	return sticks[(uint)id].strings.mapping.c_str();
+}
+
+// 不受支持的手柄获得映射后，尝试作为受支持的手柄打开
+bool GamepadOpenMapped(GMGamepad& stick)
+{
+	SDL_Gamepad* gamepad = SDL_OpenGamepad(stick.info.instance_id);
+	if (gamepad == nullptr)
+		return false;
+
+	// SDL_OpenGamepad 为已打开的摇杆增加了引用计数，之后只关闭手柄，所以这里释放原来的引用
+	SDL_CloseJoystick(stick.joystick);
+	stick.joystick = SDL_GetGamepadJoystick(gamepad);
+	stick.gamepad = gamepad;
+	stick.soft = GMSoftMapping();
+	GamepadRefresh(stick);
+	return true;
+}
+
+expReal gamepad_test_mapping(GMReal id, GMString mapping)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	SDL_JoystickID joy_id = sticks[(uint)id].info.instance_id;
+	bool result = SDL_SetGamepadMapping(joy_id, mapping);
+	if (!result)
+		return 0;
+
+	if (sticks[(uint)id].gamepad == nullptr)
+		return GamepadOpenMapped(sticks[(uint)id]);
+
+	GamepadRefresh(sticks[(uint)id]);
+	return 1;
+}
+
+expReal gamepad_remove_mapping(GMReal id)
+{
+	if (id < 0 || id >= sticks.size())
+		return 0;
+
+	SDL_JoystickID joy_id = sticks[(uint)id].info.instance_id;
+	bool result = SDL_SetGamepadMapping(joy_id, nullptr);
+	if (result)
+		GamepadRefresh(sticks[(uint)id]);
+
+	return result;
+}
+
+int GetGamepadID(SDL_JoystickID id)
+{
+	for (uint i = 0; i < sticks.size(); i++)
+	{
+		if (sticks[i].info.instance_id == id && sticks[i].gamepad != nullptr)
+			return i;
+	}
+
+	return -1;
+}
+
+int GetJoystickID(SDL_JoystickID id)
+{
+	for (uint i = 0; i < sticks.size(); i++)
+	{
+		if (sticks[i].info.instance_id == id)
+			return i;
+	}
+
+	return -1;
+}
+
+expReal gamepad_clear(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	for (uint i = 0; i < ButtonCount; i++)
+		sticks[index].button_events[i] = 0;
+
+	// 与其他按钮一样，清除时仍保持的方向在放开之前不再产生按下事件，之后新的按下照常产生
+	for (GMDirection& direction : sticks[index].directions)
+	{
+		direction.cleared = direction.sector >= 0;
+		direction.sector = -1;
+	}
+
+	sticks[index].masks = GMInputMasks();
+	return 1;
+}
+
+void GamepadButtonDown(uint index, int button, Uint64 timestamp)
+{
+	sticks[index].button_events[button + DefinedButtonOffset] |= 0b101;
+	RecordPress(index, button + DefinedButtonOffset, timestamp);
+}
+
+void GamepadButtonUp(uint index, int button)
+{
+	auto buttonEvent = &sticks[index].button_events[button + DefinedButtonOffset];
+	*buttonEvent &= 0b011;  // 关闭按钮事件
+	*buttonEvent |= 0b010;  // 打开按钮放开事件
+}
+
+// 处理已定义摇杆（126 - 131）的运动，value 为未经死区处理的归一化值
+void GamepadAxisMotion(uint index, int axis, GMReal value, Uint64 timestamp)
+{
+	GMGamepad& stick = sticks[index];
+	int slot = JoystickHatOffset - JoystickAxisOffset + axis;
+	GamepadSetAxis(stick, slot, (float)value, timestamp);
+
+	// 由于 SDL3 中 SDL_EVENT_JOYSTICK_AXIS_MOTION 事件的 my_event.jaxis.value 固定为 [-32768, 32767]
+	// 导致摇杆和扳机键的行为不一致，所以在 SDL_EVENT_GAMEPAD_AXIS_MOTION 事件中执行 ANY 操作。
+	auto buttonEvent = &stick.button_events[axis + DefinedAxisOffset];
+	auto anyAxisEvent = &stick.button_events[SDL_GAMEPAD_AXIS_ANY];
+	auto anyEvent = &stick.button_events[SDL_GAMEPAD_ANY];
+
+	bool wasHeld = (*buttonEvent & 0b100) != 0;
+	bool held = stick.axis_kernels[slot].Held(wasHeld, stick.axis_raw[slot]);
+	if (held && !wasHeld)  // 摇杆刚开始运动
+	{
+		*buttonEvent |= 0b101;  // 打开按钮按下事件，并打开摇杆状态
+		*anyAxisEvent |= 0b101;
+		*anyEvent |= 0b101;
+		RecordPress(index, axis + DefinedAxisOffset, timestamp);
+	}
+	else if (!held && wasHeld)  // 摇杆结束运动，回到原位
+	{
+		*buttonEvent &= 0b011;  // 关闭摇杆状态
+		*buttonEvent |= 0b010;  // 打开按钮放开事件
+
+		*anyAxisEvent &= 0b011;
+		*anyAxisEvent |= 0b010;
+
+		*anyEvent &= 0b011;
+		*anyEvent |= 0b010;
+	}
+}
+
+// 解析映射字符串中的一项（例如 "-leftx:a0~"、"dpup:h0.1"），无法识别的项（GUID、名称、platform 等）会被忽略
+bool ParseSoftBinding(const char* field, const char* end, int& raw, GMSoftBinding& binding)
+{
+	const char* colon = field;
+	while (colon < end && *colon != ':')
+		colon++;
+
+	if (colon == end || colon == field)
+		return false;
+
+	// 输出
+	float out_half = 0;
+	if (*field == '+' || *field == '-')
+		out_half = *field++ == '+' ? 1.0f : -1.0f;
+
+	char name[32];
+	size_t length = colon - field;
+	if (length == 0 || length >= sizeof(name))
+		return false;
+
+	SDL_memcpy(name, field, length);
+	name[length] = '\0';
+
+	int code = InputCodeFromName(name);
+	if (code < DefinedButtonOffset || code >= DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT)
+		return false;
+
+	binding.output = (Uint8)(code - DefinedButtonOffset);
+	if (code >= DefinedAxisOffset)
+	{
+		bool trigger = code == DefinedAxisOffset + SDL_GAMEPAD_AXIS_LEFT_TRIGGER || code == DefinedAxisOffset + SDL_GAMEPAD_AXIS_RIGHT_TRIGGER;
+		binding.out_lo = out_half != 0 || trigger ? 0.0f : -1.0f;
+		binding.out_hi = out_half != 0 ? out_half : 1.0f;
+	}
+	else
+	{
+		binding.out_lo = 0;
+		binding.out_hi = 1;
+	}
+
+	// 输入
+	const char* input = colon + 1;
+	float in_half = 0;
+	if (input < end && (*input == '+' || *input == '-'))
+		in_half = *input++ == '+' ? 1.0f : -1.0f;
+
+	if (input >= end)
+		return false;
+
+	char type = *input++;
+	char* next = nullptr;
+	long number = SDL_strtol(input, &next, 10);
+	if (next == input || number < 0)
+		return false;
+
+	switch (type)
+	{
+	case 'b':
+	{
+		if (number >= JoystickAxisOffset)
+			return false;
+
+		raw = (int)number;
+	}
+	break;
+	case 'a':
+	{
+		if (number >= JoystickHatOffset - JoystickAxisOffset)
+			return false;
+
+		raw = JoystickAxisOffset + (int)number;
+	}
+	break;
+	case 'h':
+	{
+		if (number >= (DefinedButtonOffset - JoystickHatOffset) / 4 || next >= end || *next != '.')
+			return false;
+
+		const char* mask_str = next + 1;
+		int directions = GamepadGetHat((int)SDL_strtol(mask_str, &next, 10));
+		if (next == mask_str || directions == 0)
+			return false;
+
+		raw = JoystickHatOffset + (int)number * 4 + SDL_MostSignificantBitIndex32(directions & -directions);
+	}
+	break;
+	default:
+		return false;
+	}
+
+	binding.in_lo = in_half != 0 ? 0.0f : -1.0f;
+	binding.in_hi = in_half != 0 ? in_half : 1.0f;
+	if (next < end && *next == '~')
+		std::swap(binding.in_lo, binding.in_hi);
+
+	return true;
+}
+
+// 将 SDL 格式的映射字符串编译为软件映射，返回绑定的数量
+int CompileSoftMapping(const char* mapping, GMSoftMapping& soft)
+{
+	struct ParsedBinding
+	{
+		int raw;
+		GMSoftBinding binding;
+	};
+
+	std::vector<ParsedBinding> parsed;
+	for (const char* field = mapping; *field != '\0';)
+	{
+		const char* end = field;
+		while (*end != '\0' && *end != ',')
+			end++;
+
+		ParsedBinding item{};
+		if (ParseSoftBinding(field, end, item.raw, item.binding))
+			parsed.push_back(item);
+
+		field = *end == ',' ? end + 1 : end;
+	}
+
+	soft = GMSoftMapping();
+	if (parsed.empty())
+		return 0;
+
+	// 按原始输入值排序存放，处理事件时只需访问该输入的绑定
+	std::array<bool, GMBindingTable::Size> filled{};
+	for (int raw = 0; raw < DefinedButtonOffset; raw++)
+	{
+		soft.first[raw] = (Uint16)soft.bindings.size();
+		for (const ParsedBinding& item : parsed)
+		{
+			if (item.raw == raw)
+				soft.bindings.push_back(item.binding);
+		}
+	}
+	soft.first[DefinedButtonOffset] = (Uint16)soft.bindings.size();
+
+	// 查询表以映射字符串中的第一个绑定为准，与 BuildBindingTable 一致
+	for (const ParsedBinding& item : parsed)
+	{
+		int output = item.binding.output;
+		if (filled[output])
+			continue;
+
+		filled[output] = true;
+		bool axis = item.raw >= JoystickAxisOffset && item.raw < JoystickHatOffset;
+		soft.table.original[output] = (Sint16)item.raw;
+		soft.table.any[output] = axis ? SDL_GAMEPAD_AXIS_ANY : SDL_GAMEPAD_BUTTON_ANY;
+	}
+
+	soft.contributions.assign(soft.bindings.size(), 0.0f);
+	soft.enabled = true;
+	return (int)soft.bindings.size();
+}
+
+// 按软件映射将原始输入的变化转换为已定义的输入。value 为归一化的值，按钮与方向键为 0 或 1。
+void SoftMappingApply(uint index, int raw, float value, Uint64 timestamp)
+{
+	GMSoftMapping& soft = sticks[index].soft;
+	if (!soft.enabled || raw < 0 || raw >= DefinedButtonOffset)
+		return;
+
+	bool digital = raw < JoystickAxisOffset || raw >= JoystickHatOffset;
+	for (int e = soft.first[raw]; e < soft.first[raw + 1]; e++)
+	{
+		const GMSoftBinding& bind = soft.bindings[e];
+
+		// 原始摇杆在绑定取值范围中的位置，半轴绑定在范围外时不产生输出
+		float t = value;
+		bool in_range = true;
+		if (!digital)
+		{
+			t = (value - bind.in_lo) / (bind.in_hi - bind.in_lo);
+			bool half = fabsf(bind.in_hi - bind.in_lo) < 1.5f;
+			in_range = !half || (t >= -0.001f && t <= 1.001f);
+			t = SDL_clamp(t, 0.0f, 1.0f);
+		}
+
+		if (bind.output < SDL_GAMEPAD_BUTTON_COUNT)
+		{
+			float active = in_range && t >= 0.5f ? 1.0f : 0.0f;
+			if (active == soft.contributions[e])
+				continue;
+
+			soft.contributions[e] = active;
+			Uint8& sources = soft.button_sources[bind.output];
+			if (active > 0)
+			{
+				if (sources++ == 0)
+					GamepadButtonDown(index, bind.output, timestamp);
+			}
+			else if (sources > 0 && --sources == 0)
+				GamepadButtonUp(index, bind.output);
+		}
+		else
+		{
+			float contribution = 0;
+			if (digital)
+				contribution = t > 0.5f ? bind.out_hi : 0.0f;
+			else if (in_range)
+				contribution = bind.out_lo + t * (bind.out_hi - bind.out_lo);
+
+			soft.contributions[e] = contribution;
+
+			// 同一输出摇杆可能由多个绑定（例如两个半轴）组成，其值为所有绑定贡献之和
+			float sum = 0;
+			for (size_t i = 0; i < soft.bindings.size(); i++)
+			{
+				if (soft.bindings[i].output == bind.output)
+					sum += soft.contributions[i];
+			}
+
+			int axis = bind.output - SDL_GAMEPAD_BUTTON_COUNT;
+			soft.axes[axis] = sum;
+			GamepadAxisMotion(index, axis, SDL_clamp(sum, -1.0f, 1.0f), timestamp);
+		}
+	}
+}
+
+// 原始按钮（0 - 59）按下，同时设定 SDL_GAMEPAD_BUTTON_ANY 和 SDL_GAMEPAD_ANY
+void JoystickButtonDown(uint index, int button, Uint64 timestamp)
+{
+	sticks[index].button_events[button] |= 0b101;
+	sticks[index].button_events[SDL_GAMEPAD_BUTTON_ANY] |= 0b101;
+	sticks[index].button_events[SDL_GAMEPAD_ANY] |= 0b101;
+	RecordPress(index, button, timestamp);
+	SoftMappingApply(index, button, 1, timestamp);
+}
+
+void JoystickButtonUp(uint index, int button, Uint64 timestamp)
+{
+	auto buttonEvent = &sticks[index].button_events[button];
+	*buttonEvent &= 0b011;  // 关闭按钮事件
+	*buttonEvent |= 0b010;  // 打开按钮放开事件
+
+	buttonEvent = &sticks[index].button_events[SDL_GAMEPAD_BUTTON_ANY];
+	*buttonEvent &= 0b011;
+	*buttonEvent |= 0b010;
+
+	buttonEvent = &sticks[index].button_events[SDL_GAMEPAD_ANY];
+	*buttonEvent &= 0b011;
+	*buttonEvent |= 0b010;
+
+	SoftMappingApply(index, button, 0, timestamp);
+}
+
+// 改变方向键的一个方向（raw 为 80 - 99）的状态，之后需要调用 JoystickHatSettle
+void JoystickHatDirection(uint index, int raw, bool down, Uint64 timestamp)
+{
+	auto event = &sticks[index].button_events[raw];
+	if (down)
+	{
+		if ((*event & 0b100) == 0)
+		{
+			*event |= 0b101;  // 打开按钮按下事件，并打开方向键状态
+			sticks[index].button_events[SDL_GAMEPAD_BUTTON_ANY] |= 0b101;
+			sticks[index].button_events[SDL_GAMEPAD_ANY] |= 0b101;
+			RecordPress(index, raw, timestamp);
+		}
+	}
+	else if ((*event & 0b100) != 0)
+	{
+		*event &= 0b011;  // 关闭按钮事件
+		*event |= 0b010;  // 打开按钮放开事件
+	}
+}
+
+// 按方向键当前的状态更新软件映射，所有方向都放开时放开 ANY
+void JoystickHatSettle(uint index, int hat, Uint64 timestamp)
+{
+	auto hatEvents = &sticks[index].button_events[JoystickHatOffset + hat * 4];
+	auto anyButtonEvent = &sticks[index].button_events[SDL_GAMEPAD_BUTTON_ANY];
+	auto anyEvent = &sticks[index].button_events[SDL_GAMEPAD_ANY];
+
+	bool any_held = false;
+	for (int d = HAT_DIRECTION_UP; d <= HAT_DIRECTION_RIGHT; d++)
+	{
+		bool held = (hatEvents[d] & 0b100) != 0;
+		any_held |= held;
+		SoftMappingApply(index, JoystickHatOffset + hat * 4 + d, held ? 1.0f : 0.0f, timestamp);
+	}
+
+	if (!any_held && (*anyButtonEvent & 0b100) != 0)
+	{
+		*anyButtonEvent &= 0b011;
+		*anyButtonEvent |= 0b010;
+
+		*anyEvent &= 0b011;
+		*anyEvent |= 0b010;
+	}
+}
+
+// 判断数字输入 code（0 - 125）的边沿是否应被接受。未开启去抖动时总是接受
+bool DebounceAccept(GMGamepad& stick, int code, bool down, Uint64 timestamp)
+{
+	GMDebounce& debounce = stick.debounce;
+	if (debounce.window == 0)
+		return true;
+
+	if (down == ((stick.button_events[code] & 0b100) != 0))
+	{
+		debounce.deferred[code] = -1;  // 抖动后回到已接受的状态
+		return false;
+	}
+
+	Uint64 last = debounce.last_edge[code];
+	if (last != 0 && timestamp - last < debounce.window)
+	{
+		debounce.deferred[code] = down;
+		debounce.pending = true;
+		return false;
+	}
+
+	debounce.deferred[code] = -1;
+	debounce.last_edge[code] = timestamp;
+	return true;
+}
+
+// 窗口结束后，补发被忽略的最终状态，例如比窗口更短的点按的放开
+void DebounceFlush()
+{
+	Uint64 now = SDL_GetTicksNS();
+	for (uint index = 0; index < sticks.size(); index++)
+	{
+		GMDebounce& debounce = sticks[index].debounce;
+		if (!debounce.pending)
+			continue;
+
+		debounce.pending = false;
+		for (int code = 0; code < DefinedAxisOffset; code++)
+		{
+			if (debounce.deferred[code] < 0)
+				continue;
+
+			bool down = debounce.deferred[code] != 0;
+			if (down == ((sticks[index].button_events[code] & 0b100) != 0))
+			{
+				debounce.deferred[code] = -1;
+				continue;
+			}
+
+			if (now - debounce.last_edge[code] < debounce.window)
+			{
+				debounce.pending = true;
+				continue;
+			}
+
+			debounce.deferred[code] = -1;
+			debounce.last_edge[code] = now;
+			if (code >= DefinedButtonOffset)
+			{
+				if (down)
+					GamepadButtonDown(index, code - DefinedButtonOffset, now);
+				else
+					GamepadButtonUp(index, code - DefinedButtonOffset);
+			}
+			else if (code >= JoystickHatOffset)
+			{
+				JoystickHatDirection(index, code, down, now);
+				JoystickHatSettle(index, (code - JoystickHatOffset) / 4, now);
+			}
+			else if (down)
+				JoystickButtonDown(index, code, now);
+			else
+				JoystickButtonUp(index, code, now);
+		}
+	}
+}
+
+// 映射数据库热重载，开发时使用：后台线程定期检查文件的修改时间，文件改变时只解析改变了的行，
+// 由 gamepad_update 通过 SDL_AddGamepadMapping 应用。已打开的手柄会收到 SDL_EVENT_GAMEPAD_REMAPPED 事件并重新生成查询表。
+struct GMMappingWatcher
+{
+	SDL_Thread* thread = nullptr;
+	SDL_Mutex* mutex = nullptr;
+	SDL_AtomicInt running;
+	SDL_AtomicInt pending_count;
+	std::string path;
+	Uint32 interval_ms = 500;
+
+	std::vector<Uint64> line_hashes;   // 后台线程上次读取时每行的哈希值，已排序
+	std::vector<std::string> pending;  // 待应用的映射，由 mutex 保护
+	std::vector<std::string> applying;
+};
+
+GMMappingWatcher mapping_watcher;
+
+Uint64 HashMappingLine(const char* begin, const char* end)
+{
+	Uint64 hash = 14695981039346656037ull;
+	for (const char* c = begin; c < end; c++)
+	{
+		hash ^= (Uint8)*c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// 跳过空行、注释以及其他平台的映射
+bool MappingLineApplies(const char* begin, const char* end)
+{
+	if (begin == end || *begin == '#')
+		return false;
+
+	constexpr char PlatformKey[] = "platform:";
+	constexpr size_t PlatformKeyLength = sizeof(PlatformKey) - 1;
+	const char* platform = SDL_GetPlatform();
+	size_t platform_length = SDL_strlen(platform);
+
+	for (const char* c = begin; c + PlatformKeyLength <= end; c++)
+	{
+		if (SDL_strncmp(c, PlatformKey, PlatformKeyLength) != 0)
+			continue;
+
+		const char* value = c + PlatformKeyLength;
+		const char* value_end = value;
+		while (value_end < end && *value_end != ',')
+			value_end++;
+
+		return (size_t)(value_end - value) == platform_length && SDL_strncmp(value, platform, platform_length) == 0;
+	}
+
+	return true;
+}
+
+// 读取文件并找出与上次读取相比新增或改变的行，baseline 为 true 时只记录当前内容
+bool MappingWatcherScan(bool baseline)
+{
+	size_t size;
+	char* data = (char*)SDL_LoadFile(mapping_watcher.path.c_str(), &size);
+	if (data == nullptr)
+		return false;
+
+	std::vector<Uint64> hashes;
+	std::vector<std::string> changed;
+	const std::vector<Uint64>& previous = mapping_watcher.line_hashes;
+	for (const char* line = data; line < data + size;)
+	{
+		const char* end = line;
+		while (end < data + size && *end != '\n')
+			end++;
+
+		const char* next = end < data + size ? end + 1 : end;
+		while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t'))
+			end--;
+
+		Uint64 hash = HashMappingLine(line, end);
+		hashes.push_back(hash);
+		if (!baseline && !std::binary_search(previous.begin(), previous.end(), hash) && MappingLineApplies(line, end))
+			changed.emplace_back(line, end);
+
+		line = next;
+	}
+
+	SDL_free(data);
+	std::sort(hashes.begin(), hashes.end());
+	mapping_watcher.line_hashes.swap(hashes);
+
+	if (!changed.empty())
+	{
+		SDL_LockMutex(mapping_watcher.mutex);
+		for (std::string& line : changed)
+			mapping_watcher.pending.push_back(std::move(line));
+
+		SDL_SetAtomicInt(&mapping_watcher.pending_count, (int)mapping_watcher.pending.size());
+		SDL_UnlockMutex(mapping_watcher.mutex);
+	}
+
+	return true;
+}
+
+int SDLCALL MappingWatcherThread(void*)
+{
+	SDL_Time last_modified = 0;
+	bool baseline = true;
+	while (SDL_GetAtomicInt(&mapping_watcher.running) != 0)
+	{
+		SDL_PathInfo info;
+		if (SDL_GetPathInfo(mapping_watcher.path.c_str(), &info) && (baseline || info.modify_time != last_modified))
+		{
+			last_modified = info.modify_time;
+			if (MappingWatcherScan(baseline))
+				baseline = false;
+		}
+
+		SDL_Delay(mapping_watcher.interval_ms);
+	}
+
+	return 0;
+}
+
+// 在主线程中应用后台线程找到的映射，返回应用的数量
+int MappingWatcherApply()
+{
+	if (SDL_GetAtomicInt(&mapping_watcher.pending_count) == 0)
+		return 0;
+
+	TraceScope scope("mapping reload");
+	SDL_LockMutex(mapping_watcher.mutex);
+	mapping_watcher.applying.swap(mapping_watcher.pending);
+	SDL_SetAtomicInt(&mapping_watcher.pending_count, 0);
+	SDL_UnlockMutex(mapping_watcher.mutex);
+
+	int applied = 0;
+	for (const std::string& line : mapping_watcher.applying)
+	{
+		if (SDL_AddGamepadMapping(line.c_str()) >= 0)
+			applied++;
+	}
+	mapping_watcher.applying.clear();
+
+	// 新的映射可能使原本不受支持的手柄变为受支持，已打开的手柄由 SDL_EVENT_GAMEPAD_REMAPPED 事件处理
+	for (GMGamepad& stick : sticks)
+	{
+		if (stick.gamepad == nullptr && SDL_IsGamepad(stick.info.instance_id))
+			GamepadOpenMapped(stick);
+	}
+
+	return applied;
+}
+
+// 本帧输入改变了的非单轴二维摇杆，以 SoA 形式存放，所有设备一起批量计算。
+// 数组长度补齐至 4 的倍数，SSE 循环不需要处理剩余部分。
+struct GMStickBatch
+{
+	struct Ref
+	{
+		uint device;
+		int stick;
+	};
+
+	std::vector<Ref> refs;
+	std::vector<float> x, y, inner, outer;                         // 输入
+	std::vector<float> magnitude, radial, scaled, bowtie_x, bowtie_y;  // 输出
+
+	void Reserve(size_t count)
+	{
+		size_t padded = (count + 3) & ~(size_t)3;
+		refs.reserve(count);
+		for (std::vector<float>* array : { &x, &y, &inner, &outer, &magnitude, &radial, &scaled, &bowtie_x, &bowtie_y })
+			array->reserve(padded);
+	}
+
+	void Resize(size_t count)
+	{
+		size_t padded = (count + 3) & ~(size_t)3;
+		for (std::vector<float>* array : { &x, &y, &inner, &outer, &magnitude, &radial, &scaled, &bowtie_x, &bowtie_y })
+			array->assign(padded, 0.0f);
+	}
+};
+
+GMStickBatch stick_batch;
+
+#ifdef GM_STICK_SSE
+void StickBatchCompute(GMStickBatch& batch)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 sign_mask = _mm_set1_ps(-0.0f);
+	for (size_t i = 0; i < batch.x.size(); i += 4)
+	{
+		__m128 x = _mm_loadu_ps(&batch.x[i]);
+		__m128 y = _mm_loadu_ps(&batch.y[i]);
+		__m128 inner = _mm_loadu_ps(&batch.inner[i]);
+		__m128 outer = _mm_loadu_ps(&batch.outer[i]);
+
+		__m128 magnitude = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+		__m128 outside = _mm_cmpgt_ps(magnitude, inner);
+		__m128 radial = _mm_and_ps(outside, _mm_min_ps(magnitude, one));
+		__m128 scaled = _mm_div_ps(_mm_sub_ps(magnitude, inner), _mm_sub_ps(outer, inner));
+		scaled = _mm_min_ps(_mm_max_ps(scaled, zero), one);
+
+		__m128 ax = _mm_andnot_ps(sign_mask, x);
+		__m128 ay = _mm_andnot_ps(sign_mask, y);
+		__m128 dzx = _mm_mul_ps(inner, ay);
+		__m128 dzy = _mm_mul_ps(inner, ax);
+		__m128 bx = _mm_div_ps(_mm_sub_ps(ax, dzx), _mm_sub_ps(one, dzx));
+		__m128 by = _mm_div_ps(_mm_sub_ps(ay, dzy), _mm_sub_ps(one, dzy));
+
+		_mm_storeu_ps(&batch.magnitude[i], magnitude);
+		_mm_storeu_ps(&batch.radial[i], radial);
+		_mm_storeu_ps(&batch.scaled[i], scaled);
+		_mm_storeu_ps(&batch.bowtie_x[i], _mm_and_ps(outside, _mm_min_ps(_mm_max_ps(bx, zero), one)));
+		_mm_storeu_ps(&batch.bowtie_y[i], _mm_and_ps(outside, _mm_min_ps(_mm_max_ps(by, zero), one)));
+	}
+}
+#else
+void StickBatchCompute(GMStickBatch& batch)
+{
+	for (size_t i = 0; i < batch.x.size(); i++)
+	{
+		float x = batch.x[i], y = batch.y[i], inner = batch.inner[i];
+		float magnitude = sqrtf(x * x + y * y);
+		batch.magnitude[i] = magnitude;
+		batch.radial[i] = magnitude > inner ? SDL_min(magnitude, 1.0f) : 0.0f;
+		batch.scaled[i] = SDL_clamp((magnitude - inner) / (batch.outer[i] - inner), 0.0f, 1.0f);
+
+		float dzx = inner * fabsf(y), dzy = inner * fabsf(x);
+		bool outside = magnitude > inner;
+		batch.bowtie_x[i] = outside ? SDL_clamp((fabsf(x) - dzx) / (1.0f - dzx), 0.0f, 1.0f) : 0.0f;
+		batch.bowtie_y[i] = outside ? SDL_clamp((fabsf(y) - dzy) / (1.0f - dzy), 0.0f, 1.0f) : 0.0f;
+	}
+}
+#endif
+
+void StickUpdatePolar(GMStick2D& stick2d)
+{
+	stick2d.magnitude = sqrtf(stick2d.x * stick2d.x + stick2d.y * stick2d.y);
+	if (stick2d.magnitude == 0)
+		return;  // 回到原位时保持上一次的角度
+
+	float angle = atan2f(-stick2d.y, stick2d.x) * (180.0f / SDL_PI_F);
+	stick2d.angle = angle < 0 ? angle + 360.0f : angle;
+}
+
+// 在帧末处理本帧输入改变了的二维摇杆
+void StickProcessBatch()
+{
+	GMStickBatch& batch = stick_batch;
+	batch.refs.clear();
+	for (uint i = 0; i < sticks.size(); i++)
+	{
+		GMGamepad& stick = sticks[i];
+		for (Uint32 dirty = stick.sticks2d_dirty; dirty != 0; dirty &= dirty - 1)
+		{
+			int n = SDL_MostSignificantBitIndex32(dirty & -dirty);
+			GMStick2D& stick2d = stick.sticks2d[n];
+			int slot = StickSlot(n);
+			if (stick2d.mode == STICK_MODE_AXIAL)
+			{
+				stick2d.x = stick.axis_values[slot];
+				stick2d.y = stick.axis_values[slot + 1];
+				StickUpdatePolar(stick2d);
+			}
+			else
+				batch.refs.push_back({ i, n });
+		}
+
+		stick.sticks2d_dirty = 0;
+	}
+
+	if (batch.refs.empty())
+		return;
+
+	TraceScope scope("stick batch");
+	batch.Resize(batch.refs.size());
+	for (size_t i = 0; i < batch.refs.size(); i++)
+	{
+		const GMGamepad& stick = sticks[batch.refs[i].device];
+		int slot = StickSlot(batch.refs[i].stick);
+		batch.x[i] = stick.axis_raw[slot];
+		batch.y[i] = stick.axis_raw[slot + 1];
+		batch.inner[i] = SDL_min(stick.axis_kernels[slot].threshold, 0.99f);
+		batch.outer[i] = SDL_max(SDL_min(stick.axis_config[slot].outer_deadzone, 1.0f), batch.inner[i] + 0.0001f);
+	}
+
+	StickBatchCompute(batch);
+
+	// 死区之后的阶段（反死区、曲线、灵敏度、反转、限制范围）使用各轴已编译的查找表
+	for (size_t i = 0; i < batch.refs.size(); i++)
+	{
+		GMGamepad& stick = sticks[batch.refs[i].device];
+		GMStick2D& stick2d = stick.sticks2d[batch.refs[i].stick];
+		int slot = StickSlot(batch.refs[i].stick);
+		const GMAxisKernel& kx = stick.axis_kernels[slot];
+		const GMAxisKernel& ky = stick.axis_kernels[slot + 1];
+		float x = batch.x[i], y = batch.y[i];
+
+		if (stick2d.mode == STICK_MODE_BOWTIE)
+		{
+			stick2d.x = batch.bowtie_x[i] > 0 ? kx.Shape(batch.bowtie_x[i]) * kx.sign * (x < 0 ? -1.0f : 1.0f) : 0.0f;
+			stick2d.y = batch.bowtie_y[i] > 0 ? ky.Shape(batch.bowtie_y[i]) * ky.sign * (y < 0 ? -1.0f : 1.0f) : 0.0f;
+		}
+		else
+		{
+			float t = stick2d.mode == STICK_MODE_RADIAL ? batch.radial[i] : batch.scaled[i];
+			float magnitude = batch.magnitude[i];
+			float shaped = t > 0 ? kx.Shape(t) / magnitude : 0.0f;
+			stick2d.x = x * shaped * kx.sign;
+			stick2d.y = y * shaped * ky.sign;
+		}
+
+		stick.axis_values[slot] = stick2d.x;
+		stick.axis_values[slot + 1] = stick2d.y;
+		GamepadOutputAxis(stick, slot, stick.axis_timestamps[slot]);
+		GamepadOutputAxis(stick, slot + 1, stick.axis_timestamps[slot + 1]);
+		stick.look[batch.refs[i].stick].Set(stick2d.x, stick2d.y, SDL_max(stick.axis_timestamps[slot], stick.axis_timestamps[slot + 1]));
+		StickUpdatePolar(stick2d);
+	}
+}
+
+// 在帧末将摇杆与十字键量化为方向，更新输入值 135 - 146 的事件
+void DirectionUpdate(uint index, Uint64 now)
+{
+	GMGamepad& stick = sticks[index];
+	constexpr int up = 1 << HAT_DIRECTION_UP;
+	constexpr int down = 1 << HAT_DIRECTION_DOWN;
+	constexpr int left = 1 << HAT_DIRECTION_LEFT;
+	constexpr int right = 1 << HAT_DIRECTION_RIGHT;
+	constexpr int FourWays[4] = { right, up, left, down };
+	constexpr int EightWays[8] = { right, up | right, up, up | left, left, down | left, down, down | right };
+
+	for (int source = 0; source < DirectionSourceCount; source++)
+	{
+		GMDirection& direction = stick.directions[source];
+		float angle, magnitude;
+		if (source == DIRECTION_SOURCE_DPAD)
+		{
+			int held = 0;
+			for (int d = HAT_DIRECTION_UP; d <= HAT_DIRECTION_RIGHT; d++)
+			{
+				if (((stick.button_events[JoystickHatOffset + d] | stick.button_events[DefinedButtonOffset + SDL_GAMEPAD_BUTTON_DPAD_UP + d]) & 0b100) != 0)
+					held |= 1 << d;
+			}
+
+			float x = ((held & right) != 0) - ((held & left) != 0);
+			float y = ((held & up) != 0) - ((held & down) != 0);
+			magnitude = sqrtf(x * x + y * y);
+			angle = atan2f(y, x) * (180.0f / SDL_PI_F);
+			angle = angle < 0 ? angle + 360.0f : angle;
+		}
+		else
+		{
+			angle = stick.sticks2d[source].angle;
+			magnitude = stick.sticks2d[source].magnitude;
+		}
+
+		int sector = direction.Quantize(angle, magnitude);
+		if (direction.cleared)
+		{
+			direction.cleared = sector >= 0;
+			sector = -1;
+		}
+
+		int held = sector < 0 ? 0 : direction.ways == 4 ? FourWays[sector] : EightWays[sector];
+		for (int d = HAT_DIRECTION_UP; d <= HAT_DIRECTION_RIGHT; d++)
+		{
+			auto event = &stick.button_events[DirectionOffset + source * 4 + d];
+			bool was_held = (*event & 0b100) != 0;
+			if ((held & (1 << d)) != 0 && !was_held)
+			{
+				*event |= 0b101;  // 打开按钮按下事件，并打开按钮状态
+				RecordPress(index, DirectionOffset + source * 4 + d, now);
+			}
+			else if ((held & (1 << d)) == 0 && was_held)
+			{
+				*event &= 0b011;  // 关闭按钮事件
+				*event |= 0b010;  // 打开按钮放开事件
+			}
+		}
+	}
+}
+
+// 将视角加速的积分推进到当前时间，得到本帧的转动量
+void LookEndFrame()
+{
+	Uint64 now = SDL_GetTicksNS();
+	for (GMGamepad& stick : sticks)
+	{
+		for (GMLookAccel& look : stick.look)
+			look.EndFrame(now);
+	}
+}
+
+// 将时间积分推进到当前时间，得到本帧的平均值。
+// SDL 只在值改变时发出事件，摇杆停止移动后平滑的值仍落后于处理后的值，
+// 所以同时以当前时间补充一次采样，使平滑的值随时间收敛
+void AxisEndFrame()
+{
+	Uint64 now = SDL_GetTicksNS();
+	for (GMGamepad& stick : sticks)
+	{
+		for (int slot = 0; slot < AxisSlotCount; slot++)
+		{
+			stick.integrators[slot].EndFrame(now);
+			if (stick.filters[slot].seeded && stick.axis_filtered[slot] != stick.axis_values[slot])
+				stick.axis_filtered[slot] = stick.filters[slot].Filter(stick.axis_values[slot], now, stick.axis_config[slot]);
+		}
+	}
+}
+
+// 修改槽位的自动死区：只重新编译该轴并用新的死区计算当前值，平滑与时间积分继续进行
+void DriftSetDeadzone(GMGamepad& stick, int slot, float deadzone, Uint64 now)
+{
+	stick.drift_deadzone[slot] = deadzone;
+	GamepadCompileAxis(stick, slot);
+	stick.axis_values[slot] = stick.axis_kernels[slot].Process(stick.axis_raw[slot]);
+	GamepadOutputAxis(stick, slot, now);
+	stick.sticks2d_dirty = (1u << StickCount) - 1;
+}
+
+// 在帧末为启用了自动死区的手柄应用建议的死区，变化超过 0.01 时才重新编译该轴。
+// 自动死区只描述这一个摇杆的磨损，保存在 drift_deadzone 中而不写入设备配置
+void DriftApplyDeadzones()
+{
+	Uint64 now = SDL_GetTicksNS();
+	for (GMGamepad& stick : sticks)
+	{
+		if (!stick.auto_deadzone)
+			continue;
+
+		for (int slot = 0; slot < AxisSlotCount; slot++)
+		{
+			float suggested = stick.drift[slot].Suggest();
+			if (suggested < 0 || fabsf(suggested - AxisInnerDeadzone(stick, slot)) <= 0.01f)
+				continue;
+
+			DriftSetDeadzone(stick, slot, suggested, now);
+		}
+	}
+}
+
+// 清除自动死区，恢复配置的内死区
+void DriftClearDeadzones(GMGamepad& stick)
+{
+	Uint64 now = SDL_GetTicksNS();
+	for (int slot = 0; slot < AxisSlotCount; slot++)
+	{
+		if (stick.drift_deadzone[slot] > 0)
+			DriftSetDeadzone(stick, slot, 0, now);
+	}
+}
+
+// 获取硬件上已经连接的手柄，并为新接入的手柄分配位置。
+// 返回 -1 表示获取失败，1 表示有新的手柄接入。
+int EnumerateGamepads()
+{
+	TraceScope enumeration_scope("enumeration");
+	bool change = false;
+	int count;
+	SDL_JoystickID* ids;
+	{
+		TraceScope scope("SDL_GetJoysticks");
+		ids = SDL_GetJoysticks(&count);
+	}
+
+	if (ids == nullptr)
+		return -1;
+
+	if ((int)sticks.size() < count)  // a new stick was attached, find it and give it a slot
+	{
+		for (int i = 0; i < count; i++)
+		{
+			bool found = false;
+
+			SDL_Joystick* newJoy = nullptr;
+			SDL_Gamepad* newGamepad;
+			{
+				TraceScope scope("SDL_OpenGamepad");
+				newGamepad = SDL_OpenGamepad(ids[i]);
+			}
+
+			if (newGamepad == nullptr)
+			{
+				TraceScope scope("SDL_OpenJoystick");
+				newJoy = SDL_OpenJoystick(ids[i]);
+				if (newJoy == nullptr)
+				{
+					enumerate_pending = true;
+					continue;
+				}
+			}
+			else
+				newJoy = SDL_GetGamepadJoystick(newGamepad);
+
+			// 检查新手柄是否已经存在于列表中
+			SDL_JoystickID id = SDL_GetJoystickID(newJoy);
+			for (uint j = 0; j < sticks.size(); j++)
+			{
+				if (id == sticks[j].info.instance_id)
+				{
+					found = true;
+					break;
+				}
+			}
+
+			if (found)  // 重复添加的会被删除
+			{
+				if (newGamepad == nullptr)
+					SDL_CloseJoystick(newJoy);
+				else
+					SDL_CloseGamepad(newGamepad);
+
+				continue;
+			}
+			else  // 新手柄会被添加至列表中
+			{
+				sticks.push_back({ newGamepad, newJoy });
+				GamepadConnect(sticks.back());
+				ProfileApply(sticks.back());
+				StatAdd(GM_STAT_DEVICES_OPENED);
+				change = true;
+			}
+		}
+	}
+
+	SDL_free(ids);
+	if (change)
+		stick_batch.Reserve(sticks.size() * StickCount);  // 之后的帧不再分配
+
+	return change;
+}
+
+expReal gamepad_update()
+{
+	Uint64 start_time = SDL_GetPerformanceCounter();
+	AllocScope alloc_scope;
+	TraceScope update_scope("gamepad_update");
+	bool change = false;
+	bool hotplug = false;
+
+	{
+		TraceScope scope("SDL_UpdateGamepads");
+		SDL_UpdateGamepads();
+	}
+
+	// 检查当前已连接的游戏手柄，并释放所有已断开连接的手柄。
+	TraceScope connection_scope("connection check");
+	for (int i = sticks.size() - 1; i >= 0; --i)
+	{
+		if (sticks[i].gamepad == nullptr)
+		{
+			// 判断不受支持的手柄的链接情况
+			if (!SDL_JoystickConnected(sticks[i].joystick))
+			{
+				SDL_CloseJoystick(sticks[i].joystick);
+				sticks.erase(sticks.begin() + i);
+				StatAdd(GM_STAT_DEVICES_CLOSED);
+				change = true;
+				hotplug = true;
+			}
+		}
+		else
+		{
+			// 判断受支持的手柄的链接情况
+			if (!SDL_GamepadConnected(sticks[i].gamepad))
+			{
+				{
+					TraceScope scope("SDL_CloseGamepad");
+					SDL_CloseGamepad(sticks[i].gamepad);
+				}
+
+				if (sticks[i].bindings != nullptr)
+					SDL_free(sticks[i].bindings);
+
+				sticks.erase(sticks.begin() + i);
+				StatAdd(GM_STAT_DEVICES_CLOSED);
+				change = true;
+				hotplug = true;
+			}
+		}
+	}
+	connection_scope.End();
+
+	// 只在有新设备接入时枚举手柄，避免每帧调用 SDL_GetJoysticks 分配内存
+	if (SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_EVENT_JOYSTICK_ADDED, SDL_EVENT_JOYSTICK_ADDED) > 0)
+		enumerate_pending = true;
+
+	if (enumerate_pending)
+	{
+		// 打开失败的设备会重新设置 enumerate_pending，下一帧重试
+		enumerate_pending = false;
+		int result = EnumerateGamepads();
+		if (result < 0)
+		{
+			enumerate_pending = true;
+			StatAdd(GM_STAT_UPDATE_TIME, SDL_GetPerformanceCounter() - start_time);
+			StatAddAllocations(true);
+			StatEndFrame();
+			return -1;
+		}
+
+		hotplug = true;
+		change |= result > 0;
+	}
+
+	hotplug |= GamepadValidateCapabilities();
+	hotplug |= MappingWatcherApply() > 0;
+
+	// 重置按钮事件
+	// 位数（从右至左）代表的含义：1.按钮按下事件  2.按钮放开事件  3.按钮事件
+	TraceScope reset_scope("reset");
+	for (uint i = 0; i < sticks.size(); i++)
+	{
+		for (uint j = 0; j < ButtonCount; j++)
+			sticks[i].button_events[j] &= 0b100;  // 不清除按钮事件(3)
+	}
+	reset_scope.End();
+
+	TraceScope drain_scope("event drain");
+	int depth = SDL_PeepEvents(nullptr, 0, SDL_PEEKEVENT, SDL_EVENT_FIRST, SDL_EVENT_LAST);
+	if (depth > 0)
+		StatAdd(GM_STAT_QUEUE_DEPTH, depth);
+
+	while (SDL_PollEvent(&my_event))
+	{
+		StatCountEvent(my_event.type);
+
+		switch (my_event.type)
+		{
+			// Gamepad
+			case SDL_EVENT_GAMEPAD_BUTTON_DOWN:
+			{
+				int joyid = GetGamepadID(my_event.gbutton.which);
+				if (joyid < 0)
+					break;
+
+				if (DebounceAccept(sticks[joyid], my_event.gbutton.button + DefinedButtonOffset, true, my_event.common.timestamp))
+					GamepadButtonDown(joyid, my_event.gbutton.button, my_event.common.timestamp);
+			}
+			break;
+
+			case SDL_EVENT_GAMEPAD_BUTTON_UP:
+			{
+				int joyid = GetGamepadID(my_event.gbutton.which);
+				if (joyid < 0)
+					break;
+
+				if (DebounceAccept(sticks[joyid], my_event.gbutton.button + DefinedButtonOffset, false, my_event.common.timestamp))
+					GamepadButtonUp(joyid, my_event.gbutton.button);
+			}
+			break;
+
+			case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+			{
+				int joyid = GetGamepadID(my_event.gaxis.which);
+				if (joyid < 0)
+					break;
+
+				GamepadAxisMotion(joyid, my_event.gaxis.axis, (GMReal)my_event.gaxis.value / 32767, my_event.common.timestamp);
+			}
+			break;
+
+			// 映射改变后（包括 gamepad_test_mapping、gamepad_remove_mapping 及热重载的映射），
+			// 重新生成 bindings 及其派生的查询表，按钮状态保持不变
+			case SDL_EVENT_GAMEPAD_REMAPPED:
+			{
+				int joyid = GetGamepadID(my_event.gdevice.which);
+				if (joyid < 0)
+					break;
+
+				GamepadRefresh(sticks[joyid]);
+				hotplug = true;
+			}
+			break;
+
+			// Joystick
+			// 因为在 SDL3 中，不支持的手柄会发出 SDL_EVENT_JOYSTICK_* 事件，支持的手柄会两个类型的事件都会发出，
+			// 所以 SDL_GAMEPAD_BUTTON_ANY 和 SDL_GAMEPAD_ANY 事件在此设定，保证泛用性。
+			case SDL_EVENT_JOYSTICK_BUTTON_DOWN:
+			{
+				int joyid = GetJoystickID(my_event.jbutton.which);
+				if (joyid < 0)
+					break;
+
+				TrackInputEvent(joyid, my_event.common.timestamp);
+
+				if (DebounceAccept(sticks[joyid], my_event.jbutton.button, true, my_event.common.timestamp))
+					JoystickButtonDown(joyid, my_event.jbutton.button, my_event.common.timestamp);
+			}
+			break;
+
+			case SDL_EVENT_JOYSTICK_BUTTON_UP:
+			{
+				int joyid = GetJoystickID(my_event.jbutton.which);
+				if (joyid < 0)
+					break;
+
+				TrackInputEvent(joyid, my_event.common.timestamp);
+
+				if (DebounceAccept(sticks[joyid], my_event.jbutton.button, false, my_event.common.timestamp))
+					JoystickButtonUp(joyid, my_event.jbutton.button, my_event.common.timestamp);
+			}
+			break;
+
+			case SDL_EVENT_JOYSTICK_AXIS_MOTION:
+			{
+				int joyid = GetJoystickID(my_event.jbutton.which);
+				if (joyid < 0)
+					break;
+
+				TrackInputEvent(joyid, my_event.common.timestamp);
+
+				if (my_event.jaxis.axis >= JoystickHatOffset - JoystickAxisOffset)
+					break;
+
+				float raw_value = SDL_clamp(my_event.jaxis.value / 32767.0f, -1.0f, 1.0f);
+				int slot = my_event.jaxis.axis;
+				GamepadSetAxis(sticks[joyid], slot, raw_value, my_event.common.timestamp);
+
+				auto buttonEvent = &sticks[joyid].button_events[JoystickAxisOffset + my_event.jaxis.axis];
+				bool wasHeld = (*buttonEvent & 0b100) != 0;
+				bool held = sticks[joyid].axis_kernels[slot].Held(wasHeld, sticks[joyid].axis_raw[slot]);
+
+				if (held && !wasHeld)  // 摇杆刚开始运动
+				{
+					*buttonEvent |= 0b101;  // 打开按钮按下事件，并打开摇杆状态
+					RecordPress(joyid, JoystickAxisOffset + my_event.jaxis.axis, my_event.common.timestamp);
+				}
+				else if (!held && wasHeld)  // 摇杆结束运动，回到原位
+				{
+					*buttonEvent &= 0b011;  // 关闭摇杆状态
+					*buttonEvent |= 0b010;  // 打开按钮放开事件
+				}
+
+				SoftMappingApply(joyid, JoystickAxisOffset + my_event.jaxis.axis, raw_value, my_event.common.timestamp);
+			}
+			break;
+
+			case SDL_EVENT_JOYSTICK_HAT_MOTION:
+			{
+				int joyid = GetJoystickID(my_event.jbutton.which);
+				if (joyid < 0)
+					break;
+
+				TrackInputEvent(joyid, my_event.common.timestamp);
+
+				int directions = GamepadGetHat(my_event.jhat.value);
+				for (int d = HAT_DIRECTION_UP; d <= HAT_DIRECTION_RIGHT; d++)
+				{
+					int raw = JoystickHatOffset + my_event.jhat.hat * 4 + d;
+					bool down = (directions & (1 << d)) != 0;
+					if (DebounceAccept(sticks[joyid], raw, down, my_event.common.timestamp))
+						JoystickHatDirection(joyid, raw, down, my_event.common.timestamp);
+				}
+
+				JoystickHatSettle(joyid, my_event.jhat.hat, my_event.common.timestamp);
+			}
+			break;
+		}
+	}
+
+	drain_scope.End();
+
+	DebounceFlush();
+	DriftApplyDeadzones();
+	StickProcessBatch();
+	AxisEndFrame();
+	LookEndFrame();
+	Uint64 now = SDL_GetTicksNS();
+	for (uint i = 0; i < sticks.size(); i++)
+	{
+		DirectionUpdate(i, now);
+		GamepadSyncMasks(sticks[i]);
+	}
+
+	// 只统计 SDL_EVENT_JOYSTICK_* 事件：受支持的手柄的每次输入都会同时发出两类事件，避免重复计入
+	LatencyFlush();
+	hotplug |= FileStoreQueueSave();
+
+	StatAdd(GM_STAT_UPDATE_TIME, SDL_GetPerformanceCounter() - start_time);
+	StatAddAllocations(hotplug);
+	StatEndFrame();
+
+	return change;
+}
+
+expReal gamepad_get_stat(GMReal stat, GMReal kind)
+{
+	int index = (int)stat;
+	if (index < 0 || index >= GM_STAT_COUNT)
+		return -1;
+
+	double value;
+	switch ((int)kind)
+	{
+	case GM_STAT_KIND_LAST: value = (double)stats.last[index]; break;
+	case GM_STAT_KIND_TOTAL: value = (double)stats.total[index]; break;
+	case GM_STAT_KIND_MAX: value = (double)stats.max[index]; break;
+	case GM_STAT_KIND_AVERAGE:
+	{
+		if (stats.frames == 0)
+			return 0;
+
+		value = (double)stats.total[index] / stats.frames;
+	}
+	break;
+	default: return -1;
+	}
+
+	// 耗时以性能计数器的计数保存，导出时换算为微秒
+	if (index == GM_STAT_UPDATE_TIME)
+		value = value * 1000000 / SDL_GetPerformanceFrequency();
+
+	return value;
+}
+
+expReal gamepad_get_stat_frames() { return (double)stats.frames; }
+
+expReal gamepad_reset_stats()
+{
+	stats = GMStats();
+	return 1;
+}
+expReal gamepad_trace_enable(GMReal enable)
+{
+	trace.enabled = enable > 0.5;
+	return 1;
+}
+
+// 返回追踪所用时间轴上的当前时间（微秒），便于与游戏自身的计时对齐
+expReal gamepad_trace_get_time() { return SDL_GetTicksNS() / 1000.0; }
+
+// 将环形缓冲区中的记录以 Chrome trace 格式（JSON）写入文件，并清空缓冲区。
+// 返回写入的记录数，失败时返回 -1。
+expReal gamepad_trace_flush(GMString filename)
+{
+	SDL_IOStream* io = SDL_IOFromFile(filename, "w");
+	if (io == nullptr)
+		return -1;
+
+	SDL_IOprintf(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	SDL_IOprintf(io, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GMGamepad\"}}");
+
+	uint first = (trace.head + TraceCapacity - trace.count) % TraceCapacity;
+	for (uint i = 0; i < trace.count; i++)
+	{
+		const GMTraceSpan& span = trace.spans[(first + i) % TraceCapacity];
+		SDL_IOprintf(io, ",\n{\"name\":\"%s\",\"cat\":\"input\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+			span.name, span.begin / 1000.0, (span.end - span.begin) / 1000.0);
+	}
+
+	SDL_IOprintf(io, "\n]}\n");
+	bool result = SDL_CloseIO(io);
+
+	uint written = trace.count;
+	trace.head = 0;
+	trace.count = 0;
+
+	return result ? written : -1;
+}
+
+// 返回指定百分位的输入延迟（微秒），例如 percent 为 99 时返回 p99
+expReal gamepad_get_latency(GMReal id, GMReal percent)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return -1;
+
+	return sticks[index].latency.Percentile(percent);
+}
+
+expReal gamepad_get_latency_count(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return (double)sticks[index].latency.count;
+}
+
+expReal gamepad_reset_latency(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	sticks[index].latency = GMLatencyHistogram();
+	return 1;
+}
+
+// 返回手柄的有效上报率（Hz）
+expReal gamepad_get_report_rate(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].report.Rate();
+}
+
+// 返回上报间隔的标准差（微秒）
+expReal gamepad_get_report_jitter(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].report.Jitter();
+}
+
+// 返回上报间隔的最大值（毫秒）
+expReal gamepad_get_report_max_interval(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return (double)sticks[index].report.max_interval / SDL_NS_PER_MS;
+}
+
+// 返回超过阈值的上报间隔次数，可能是无线手柄掉线
+expReal gamepad_get_report_gaps(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return (double)sticks[index].report.gaps;
+}
+
+expReal gamepad_set_report_gap_threshold(GMReal id, GMReal ms)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size() || ms <= 0)
+		return 0;
+
+	sticks[index].report.gap_threshold = (Uint64)(ms * SDL_NS_PER_MS);
+	return 1;
+}
+
+expReal gamepad_reset_report_stats(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	GMReportStats& report = sticks[index].report;
+	report = { report.last_timestamp, report.gap_threshold };
+	return 1;
+}
+
+// 返回 SDL_JoystickConnectionState：-1 无效，0 未知，1 有线，2 无线
+expReal gamepad_get_connection_state(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return -1;
+
+	return sticks[index].info.connection_state;
+}
+
+// 开启或关闭堆分配统计，结果通过 gamepad_get_stat 的 GM_STAT_*ALLOCATION* 项查看。
+// SDL 的分配只有在 gamepad_init 之后才能统计。
+expReal gamepad_set_alloc_tracking(GMReal enable)
+{
+	SDL_SetAtomicInt(&alloc_tracking, enable > 0.5);
+	SDL_SetAtomicInt(&allocations, 0);
+	SDL_SetAtomicInt(&sdl_allocations, 0);
+	return sdl_malloc != nullptr;
+}
+
+// 多输入查询：m0 - m4 为输入值的位掩码，第 n 个参数的第 k 位对应输入值 32 * n + k。
+// 只需一次调用即可判断多个按钮中的任意一个（或全部）是否处于按下、刚按下或刚放开的状态。
+// 掩码限制在 0 - 4294967295 之间，负数与 NaN 视为 0（-1 不表示所有位，所有位应使用 4294967295）。
+enum InputMaskState
+{
+	INPUT_MASK_HELD,
+	INPUT_MASK_PRESSED,
+	INPUT_MASK_RELEASED
+};
+
+static_assert(InputMaskWords == 5, "the mask query exports take exactly 5 mask words");
+
+GMReal GamepadMaskCheck(GMReal id, InputMaskState state, bool all, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	const GMInputMasks& masks = sticks[index].masks;
+	const std::array<Uint32, InputMaskWords>& bits =
+		state == INPUT_MASK_HELD ? masks.held : state == INPUT_MASK_PRESSED ? masks.pressed : masks.released;
+
+	const GMReal query[InputMaskWords] = { m0, m1, m2, m3, m4 };
+	bool any_match = false;
+	bool all_match = true;
+	for (int i = 0; i < InputMaskWords; i++)
+	{
+		GMReal value = query[i] == query[i] ? SDL_clamp(query[i], 0.0, 4294967295.0) : 0.0;  // NaN 不等于自身
+		Uint32 mask = (Uint32)value;
+		Uint32 match = bits[i] & mask;
+		any_match |= match != 0;
+		all_match &= match == mask;
+	}
+
+	return all ? all_match : any_match;
+}
+
+expReal gamepad_mask_check(GMReal id, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	return GamepadMaskCheck(id, INPUT_MASK_HELD, false, m0, m1, m2, m3, m4);
+}
+
+expReal gamepad_mask_check_all(GMReal id, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	return GamepadMaskCheck(id, INPUT_MASK_HELD, true, m0, m1, m2, m3, m4);
+}
+
+expReal gamepad_mask_check_pressed(GMReal id, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	return GamepadMaskCheck(id, INPUT_MASK_PRESSED, false, m0, m1, m2, m3, m4);
+}
+
+expReal gamepad_mask_check_pressed_all(GMReal id, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	return GamepadMaskCheck(id, INPUT_MASK_PRESSED, true, m0, m1, m2, m3, m4);
+}
+
+expReal gamepad_mask_check_released(GMReal id, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	return GamepadMaskCheck(id, INPUT_MASK_RELEASED, false, m0, m1, m2, m3, m4);
+}
+
+expReal gamepad_mask_check_released_all(GMReal id, GMReal m0, GMReal m1, GMReal m2, GMReal m3, GMReal m4)
+{
+	return GamepadMaskCheck(id, INPUT_MASK_RELEASED, true, m0, m1, m2, m3, m4);
+}
+
+// 返回手柄最近一次按下的输入值，没有时返回 -1
+expReal gamepad_get_last_pressed(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return -1;
+
+	return sticks[index].last_pressed.code;
+}
+
+// 返回手柄最近一次按下输入的时间（毫秒，SDL 时间轴）
+expReal gamepad_get_last_pressed_time(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return (double)sticks[index].last_pressed.timestamp / SDL_NS_PER_MS;
+}
+
+// 返回最近一次有输入的手柄下标，没有或已断开时返回 -1
+expReal gamepad_get_last_active()
+{
+	if (last_active_input.code < 0)
+		return -1;
+
+	return GetJoystickID(last_active_device);
+}
+
+expReal gamepad_get_last_active_input() { return last_active_input.code; }
+
+expReal gamepad_get_last_active_time() { return (double)last_active_input.timestamp / SDL_NS_PER_MS; }
+
+// 清除最近一次按下的记录，例如在“按任意键绑定”界面打开时调用。id 小于 0 时清除所有手柄及全局记录。
+expReal gamepad_reset_last_pressed(GMReal id)
+{
+	if (id < 0)
+	{
+		for (GMGamepad& stick : sticks)
+			stick.last_pressed = GMLastInput();
+
+		last_active_input = GMLastInput();
+		last_active_device = 0;
+		return 1;
+	}
+
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	sticks[index].last_pressed = GMLastInput();
+	return 1;
+}
+
+// 为 SDL 无法识别的手柄设置软件映射，mapping 为 SDL 格式的映射字符串（GUID 与名称可省略）。
+// 原始输入会在处理事件时转换为已定义的输入值（100 - 131），查询时没有额外开销。返回绑定的数量。
+expReal gamepad_set_soft_mapping(GMReal id, GMString mapping)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size() || sticks[index].gamepad != nullptr)
+		return 0;
+
+	GMGamepad& stick = sticks[index];
+	int count = CompileSoftMapping(mapping, stick.soft);
+	if (count > 0)
+		stick.soft.source = mapping;
+
+	// 清除由旧映射产生的已定义输入状态
+	for (int i = DefinedButtonOffset; i < DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT; i++)
+		stick.button_events[i] = 0;
+
+	GamepadRebuildBindings(stick);
+	GamepadSyncMasks(stick);
+	GamepadSeedAxes(stick);
+	ProfileStore(stick);
+	return count;
+}
+
+expReal gamepad_remove_soft_mapping(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size() || !sticks[index].soft.enabled)
+		return 0;
+
+	GMGamepad& stick = sticks[index];
+	stick.soft = GMSoftMapping();
+	for (int i = DefinedButtonOffset; i < DefinedAxisOffset + SDL_GAMEPAD_AXIS_COUNT; i++)
+		stick.button_events[i] = 0;
+
+	GamepadRebuildBindings(stick);
+	GamepadSyncMasks(stick);
+	GamepadSeedAxes(stick);
+	ProfileStore(stick);
+	return 1;
+}
+
+expReal gamepad_has_soft_mapping(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].soft.enabled;
+}
+
+// 打开配置文件，之后对死区与软件映射的修改会自动保存至该文件。
+// 文件中的配置会替换内存中的配置，并立即应用至已连接的手柄。返回读取的配置数量，文件格式错误时返回 -1。
+expReal gamepad_profile_open(GMString filename)
+{
+	if (*filename == '\0')
+		return -1;
+
+	std::vector<GMProfile> profiles;
+	GMMappedFile file;
+	bool valid = true;
+	if (file.Open(filename))
+		valid = ProfileParse(file.data, file.size, profiles);
+	file.Close();
+
+	if (!valid || !FileWriterStart())
+		return -1;
+
+	profile_store.profiles.swap(profiles);
+	profile_store.path = filename;
+	profile_store.dirty = false;
+
+	for (GMGamepad& stick : sticks)
+		ProfileApply(stick);
+
+	return profile_store.profiles.size();
+}
+
+// 等待所有修改写入文件，通常在游戏结束前调用
+expReal gamepad_profile_flush()
+{
+	if (file_writer.thread == nullptr)
+		return 0;
+
+	FileStoreQueueSave();
+	FileWriterWait();
+	return 1;
+}
+
+// 删除手柄对应的配置，当前的设置不会改变
+expReal gamepad_profile_remove(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	for (size_t i = 0; i < profile_store.profiles.size(); i++)
+	{
+		if (SDL_memcmp(&profile_store.profiles[i].guid, &sticks[index].info.guid, sizeof(SDL_GUID)) == 0)
+		{
+			profile_store.profiles.erase(profile_store.profiles.begin() + i);
+			profile_store.dirty = true;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// 打开能力缓存文件，之后接入的受支持手柄会优先使用缓存。返回读取的记录数量，文件格式错误时返回 -1。
+// 通常在 gamepad_init 之后、第一次调用 gamepad_update 之前调用。
+expReal gamepad_capability_cache_open(GMString filename)
+{
+	if (*filename == '\0')
+		return -1;
+
+	std::vector<GMCapability> entries;
+	GMMappedFile file;
+	bool valid = true;
+	if (file.Open(filename))
+		valid = CapabilityParse(file.data, file.size, entries);
+	file.Close();
+
+	if (!valid || !FileWriterStart())
+		return -1;
+
+	// 保留本次运行中已经接入的手柄
+	Uint32 count = (Uint32)entries.size();
+	for (const GMCapability& entry : capability_cache.entries)
+	{
+		bool found = false;
+		for (const GMCapability& loaded : entries)
+			found |= loaded.firmware == entry.firmware && SDL_memcmp(&loaded.guid, &entry.guid, sizeof(SDL_GUID)) == 0;
+
+		if (!found)
+			entries.push_back(entry);
+	}
+
+	capability_cache.entries.swap(entries);
+	capability_cache.path = filename;
+	capability_cache.dirty = count != capability_cache.entries.size();
+	return count;
+}
+
+expReal gamepad_get_firmware_version(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].info.firmware;
+}
+
+// type 为 SDL_SensorType
+expReal gamepad_has_sensor(GMReal id, GMReal type)
+{
+	uint index = (uint)id;
+	uint sensor = (uint)type;
+	if (index >= sticks.size() || sensor >= 32)
+		return 0;
+
+	return (sticks[index].info.sensor_mask & (1u << sensor)) != 0;
+}
+
+expReal gamepad_get_touchpad_count(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].info.touchpad_count;
+}
+
+// 开始监视映射数据库文件（通常与 gamepad_init 使用同一文件），文件改变时自动应用新增或改变的映射。
+// interval 为检查文件修改时间的间隔（毫秒）。只用于开发，发布时不需要调用。
+expReal gamepad_mapping_watch(GMString filename, GMReal interval)
+{
+	if (*filename == '\0' || mapping_watcher.thread != nullptr)
+		return 0;
+
+	if (mapping_watcher.mutex == nullptr)
+		mapping_watcher.mutex = SDL_CreateMutex();
+	if (mapping_watcher.mutex == nullptr)
+		return 0;
+
+	mapping_watcher.path = filename;
+	mapping_watcher.interval_ms = (Uint32)SDL_clamp(interval, 10.0, 60000.0);
+	mapping_watcher.line_hashes.clear();
+	SDL_SetAtomicInt(&mapping_watcher.running, 1);
+	mapping_watcher.thread = SDL_CreateThread(MappingWatcherThread, "GMGamepad mapping watcher", nullptr);
+	if (mapping_watcher.thread == nullptr)
+	{
+		SDL_SetAtomicInt(&mapping_watcher.running, 0);
+		return 0;
+	}
+
+	return 1;
+}
+
+expReal gamepad_mapping_unwatch()
+{
+	if (mapping_watcher.thread == nullptr)
+		return 0;
+
+	SDL_SetAtomicInt(&mapping_watcher.running, 0);
+	SDL_WaitThread(mapping_watcher.thread, nullptr);
+	mapping_watcher.thread = nullptr;
+
+	SDL_LockMutex(mapping_watcher.mutex);
+	mapping_watcher.pending.clear();
+	SDL_SetAtomicInt(&mapping_watcher.pending_count, 0);
+	SDL_UnlockMutex(mapping_watcher.mutex);
+	return 1;
+}
+
+// 关闭所有手柄并结束后台线程，待写入的配置会先写入文件。之后可以再次调用 gamepad_init
+expReal gamepad_quit()
+{
+	FileStoreQueueSave();
+	FileWriterStop();
+	gamepad_mapping_unwatch();
+
+	for (GMGamepad& stick : sticks)
+	{
+		if (stick.gamepad != nullptr)
+		{
+			SDL_CloseGamepad(stick.gamepad);
+			SDL_free(stick.bindings);
+		}
+		else
+			SDL_CloseJoystick(stick.joystick);
+	}
+
+	sticks.clear();
+	SDL_Quit();
+	enumerate_pending = true;
+	return 1;
+}
+
+// 摇杆处理流水线的配置。axis 为摇杆的输入值（60 - 79、126 - 131），为 -1 时设置所有摇杆。
+// 修改会立即编译为新的处理函数，并保存至设备配置。
+bool GamepadConfigureAxis(GMReal id, GMReal axis, void (*apply)(GMAxisConfig&, GMReal), GMReal value)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return false;
+
+	GMGamepad& stick = sticks[index];
+	int slot = AxisSlot((int)axis);
+	if (axis == -1)
+	{
+		for (GMAxisConfig& config : stick.axis_config)
+			apply(config, value);
+	}
+	else if (slot >= 0)
+		apply(stick.axis_config[slot], value);
+	else
+		return false;
+
+	GamepadAxisConfigChanged(stick);
+	return true;
+}
+
+expReal gamepad_set_axis_inner_deadzone(GMReal id, GMReal axis, GMReal deadzone)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.inner_deadzone = (float)SDL_clamp(v, 0.0, 1.0); }, deadzone);
+}
+
+expReal gamepad_set_axis_outer_deadzone(GMReal id, GMReal axis, GMReal deadzone)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.outer_deadzone = (float)SDL_clamp(v, 0.0, 1.0); }, deadzone);
+}
+
+expReal gamepad_set_axis_anti_deadzone(GMReal id, GMReal axis, GMReal deadzone)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.anti_deadzone = (float)SDL_clamp(v, 0.0, 1.0); }, deadzone);
+}
+
+// exponent 为响应曲线的指数：1 为线性，大于 1 时小幅度的移动更精细
+expReal gamepad_set_axis_curve(GMReal id, GMReal axis, GMReal exponent)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.curve = (float)SDL_clamp(v, 0.01, 100.0); }, exponent);
+}
+
+expReal gamepad_set_axis_sensitivity(GMReal id, GMReal axis, GMReal sensitivity)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.sensitivity = (float)SDL_max(v, 0.0); }, sensitivity);
+}
+
+expReal gamepad_set_axis_invert(GMReal id, GMReal axis, GMReal invert)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.invert = v != 0; }, invert);
+}
+
+expReal gamepad_set_axis_clamp(GMReal id, GMReal axis, GMReal limit)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.clamp = (float)SDL_clamp(v, 0.0, 1.0); }, limit);
+}
+
+// 恢复默认配置，内死区使用 gamepad_set_axis_deadzone 设置的值
+expReal gamepad_reset_axis_config(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	float deadzone = (float)sticks[index].deadzone;
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config = GMAxisConfig(); config.inner_deadzone = (float)v; }, deadzone);
+}
+
+// 设置二维摇杆的死区模式（StickMode）。stick 为摇杆 X 轴的输入值：126 为左摇杆，128 为右摇杆，60、62 …… 为原始摇杆对。
+// 非单轴模式下，gamepad_axis_value 返回二维处理后的值。
+expReal gamepad_set_stick_mode(GMReal id, GMReal stick, GMReal mode)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	int imode = (int)mode;
+	if (index >= sticks.size() || n < 0 || imode < 0 || imode >= STICK_MODE_COUNT)
+		return 0;
+
+	GMGamepad& gamepad = sticks[index];
+	gamepad.sticks2d[n].mode = (Uint8)imode;
+
+	// 恢复单轴处理的值，下一次 gamepad_update 时重新计算
+	int slot = StickSlot(n);
+	gamepad.axis_values[slot] = gamepad.axis_kernels[slot].Process(gamepad.axis_raw[slot]);
+	gamepad.axis_values[slot + 1] = gamepad.axis_kernels[slot + 1].Process(gamepad.axis_raw[slot + 1]);
+	gamepad.sticks2d_dirty |= 1u << n;
+	ProfileStore(gamepad);
+	return 1;
+}
+
+expReal gamepad_get_stick_mode(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].sticks2d[n].mode;
+}
+
+expReal gamepad_stick_x(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].sticks2d[n].x;
+}
+
+expReal gamepad_stick_y(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].sticks2d[n].y;
+}
+
+// 摇杆的方向（度），与 point_direction 一致。摇杆回到原位时保持上一次的方向。
+expReal gamepad_stick_angle(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].sticks2d[n].angle;
+}
+
+expReal gamepad_stick_magnitude(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].sticks2d[n].magnitude;
+}
+
+bool GamepadConfigureLook(GMReal id, GMReal stick, void (*apply)(GMLookAccel&, GMReal), GMReal value)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return false;
+
+	GMLookAccel& look = sticks[index].look[n];
+	apply(look, value);
+	look.held = 0;
+	ProfileStore(sticks[index]);
+	return true;
+}
+
+// 视角加速的时间（秒）：在边缘停留这么久后达到最大倍率，0 为关闭加速
+expReal gamepad_set_stick_look_ramp(GMReal id, GMReal stick, GMReal seconds)
+{
+	return GamepadConfigureLook(id, stick, [](GMLookAccel& look, GMReal v) { look.ramp_time = (float)SDL_max(v, 0.0); }, seconds);
+}
+
+expReal gamepad_set_stick_look_max(GMReal id, GMReal stick, GMReal multiplier)
+{
+	return GamepadConfigureLook(id, stick, [](GMLookAccel& look, GMReal v) { look.max_multiplier = (float)SDL_max(v, 1.0); }, multiplier);
+}
+
+// 视为推到边缘的距离 [0, 1]，默认为 0.9
+expReal gamepad_set_stick_look_edge(GMReal id, GMReal stick, GMReal threshold)
+{
+	return GamepadConfigureLook(id, stick, [](GMLookAccel& look, GMReal v) { look.edge = (float)SDL_clamp(v, 0.0, 1.0); }, threshold);
+}
+
+// 上一帧的转动量（摇杆值 × 秒，已乘以加速倍率），乘以每秒的转动速度即为本帧应转动的角度
+expReal gamepad_stick_look_x(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].look[n].delta_x;
+}
+
+expReal gamepad_stick_look_y(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].look[n].delta_y;
+}
+
+// 当前的加速倍率
+expReal gamepad_stick_look_multiplier(GMReal id, GMReal stick)
+{
+	uint index = (uint)id;
+	int n = StickIndex((int)stick);
+	if (index >= sticks.size() || n < 0)
+		return 0;
+
+	return sticks[index].look[n].Multiplier();
+}
+
+// 设置方向量化（DirectionSource）：0 为左摇杆，1 为右摇杆，2 为十字键。ways 为 4 或 8，0 为关闭
+expReal gamepad_set_direction_mode(GMReal id, GMReal source, GMReal ways)
+{
+	uint index = (uint)id;
+	uint n = (uint)source;
+	int iways = (int)ways;
+	if (index >= sticks.size() || n >= DirectionSourceCount || (iways != 0 && iways != 4 && iways != 8))
+		return 0;
+
+	GMDirection& direction = sticks[index].directions[n];
+	direction.ways = (Uint8)iways;
+	direction.sector = -1;  // 下一次 gamepad_update 时重新量化
+	ProfileStore(sticks[index]);
+	return 1;
+}
+
+// 方向切换的角度滞回（度），不超过扇区宽度的 45%
+expReal gamepad_set_direction_hysteresis(GMReal id, GMReal source, GMReal degrees)
+{
+	uint index = (uint)id;
+	uint n = (uint)source;
+	if (index >= sticks.size() || n >= DirectionSourceCount)
+		return 0;
+
+	sticks[index].directions[n].hysteresis = (float)SDL_max(degrees, 0.0);
+	ProfileStore(sticks[index]);
+	return 1;
+}
+
+// 摇杆产生方向的最小距离，默认为 0.5
+expReal gamepad_set_direction_threshold(GMReal id, GMReal source, GMReal threshold)
+{
+	uint index = (uint)id;
+	uint n = (uint)source;
+	if (index >= sticks.size() || n >= DirectionSourceCount)
+		return 0;
+
+	sticks[index].directions[n].threshold = (float)SDL_clamp(threshold, 0.01, 1.0);
+	ProfileStore(sticks[index]);
+	return 1;
+}
+
+// 启用或关闭摇杆校准。启用后在处理事件时学习摇杆的中心、范围与外框形状，并在死区之前修正。
+expReal gamepad_set_calibration(GMReal id, GMReal enable)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	sticks[index].calibration.enabled = enable != 0;
+	GamepadSeedAxes(sticks[index]);
+	return 1;
+}
+
+// 暂停或继续学习，暂停后保持已学习的结果
+expReal gamepad_set_calibration_learning(GMReal id, GMReal enable)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	sticks[index].calibration.learning = enable != 0;
+	return 1;
+}
+
+expReal gamepad_reset_calibration(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	GMCalibration& calibration = sticks[index].calibration;
+	calibration.axes = {};
+	calibration.gates = {};
+	GamepadSeedAxes(sticks[index]);
+	return 1;
+}
+
+// 学习到的摇杆中心（原始值）
+expReal gamepad_get_axis_center(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int slot = AxisSlot((int)axis);
+	if (index >= sticks.size() || slot < 0)
+		return 0;
+
+	return sticks[index].calibration.axes[slot].center;
+}
+
+// 摇杆是否存在漂移：原位的偏移超出了当前的内死区。样本不足时返回 0。
+expReal gamepad_get_axis_drift(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int slot = AxisSlot((int)axis);
+	if (index >= sticks.size() || slot < 0)
+		return 0;
+
+	float suggested = sticks[index].drift[slot].Suggest();
+	return suggested > AxisInnerDeadzone(sticks[index], slot);
+}
+
+// 能够屏蔽漂移的最小内死区，样本不足时返回 -1
+expReal gamepad_get_suggested_deadzone(GMReal id, GMReal axis)
+{
+	uint index = (uint)id;
+	int slot = AxisSlot((int)axis);
+	if (index >= sticks.size() || slot < 0)
+		return -1;
+
+	return sticks[index].drift[slot].Suggest();
+}
+
+// 启用后在 gamepad_update 中自动将各轴的内死区调整为建议值。
+// 自动死区只对这一个设备生效，不会保存至设备配置；关闭时恢复配置的内死区
+expReal gamepad_set_auto_deadzone(GMReal id, GMReal enable)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	sticks[index].auto_deadzone = enable != 0;
+	if (!sticks[index].auto_deadzone)
+		DriftClearDeadzones(sticks[index]);
+
+	return 1;
+}
+
+expReal gamepad_reset_drift(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	sticks[index].drift = {};
+	DriftClearDeadzones(sticks[index]);
+	return 1;
+}
+
+// 设置按钮与方向键的去抖动窗口（微秒），0 表示关闭。按下立即生效，窗口内的抖动被忽略
+expReal gamepad_set_debounce(GMReal id, GMReal microseconds)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	GMDebounce& debounce = sticks[index].debounce;
+	debounce.window = (Uint64)(SDL_max(microseconds, 0.0) * 1000);
+	debounce.pending = false;
+	debounce.deferred.fill(-1);
+	ProfileStore(sticks[index]);
+	return 1;
+}
+
+expReal gamepad_get_debounce(GMReal id)
+{
+	uint index = (uint)id;
+	if (index >= sticks.size())
+		return 0;
+
+	return sticks[index].debounce.window / 1000.0;
+}
+
+// 摇杆作为按钮使用时的按下阈值（输出值的绝对值），与模拟量的死区无关
+expReal gamepad_set_axis_press_threshold(GMReal id, GMReal axis, GMReal threshold)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.press_threshold = (float)SDL_clamp(v, 0.0, 1.0); }, threshold);
+}
+
+// 放开阈值，大于按下阈值时视为与按下阈值相同
+expReal gamepad_set_axis_release_threshold(GMReal id, GMReal axis, GMReal threshold)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.release_threshold = (float)SDL_clamp(v, 0.0, 1.0); }, threshold);
+}
+
+// One-Euro 平滑的最小截止频率（Hz），越小静止时越平稳，0 为关闭。常用值为 1 左右
+expReal gamepad_set_axis_filter_min_cutoff(GMReal id, GMReal axis, GMReal hz)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.filter_min_cutoff = (float)SDL_max(v, 0.0); }, hz);
+}
+
+// 速度系数，越大快速移动时的延迟越小
+expReal gamepad_set_axis_filter_beta(GMReal id, GMReal axis, GMReal beta)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.filter_beta = (float)SDL_max(v, 0.0); }, beta);
+}
+
+// 平滑速度时使用的截止频率（Hz），默认为 1
+expReal gamepad_set_axis_filter_d_cutoff(GMReal id, GMReal axis, GMReal hz)
+{
+	return GamepadConfigureAxis(id, axis, [](GMAxisConfig& config, GMReal v) { config.filter_d_cutoff = (float)SDL_max(v, 0.001); }, hz);
+}